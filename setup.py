@@ -39,6 +39,7 @@ ext = Extension(
         "src/p4p_top.cpp",
         "src/p4p_type.cpp",
         "src/p4p_value.cpp",
+        "src/p4p_json.cpp",
         "src/p4p_array.cpp",
 
         "src/p4p_server.cpp",
@@ -46,6 +47,7 @@ ext = Extension(
         "src/p4p_server_sharedpv.cpp",
 
         "src/p4p_client.cpp",
+        "src/p4p_recorder.cpp",
     ],
     include_dirs = get_numpy_include_dirs()+[epicscorelibs.path.include_path],
     define_macros = get_config_var('CPPFLAGS'),
@@ -1,4 +1,8 @@
 
+#include <algorithm>
+
+#include <errlog.h>
+
 #include "gwchannel.h"
 #include "_gw.h"
 
@@ -52,6 +56,97 @@ void GWInstallClientAliased(const pva::ChannelProvider::shared_pointer& provider
         throw std::invalid_argument(installAs+" Client provider already registered");
 }
 
+size_t GWSizeOf(const pvd::PVField& fld)
+{
+    switch(fld.getField()->getType()) {
+    case pvd::scalar: {
+        const pvd::PVScalar& S = static_cast<const pvd::PVScalar&>(fld);
+        pvd::ScalarType stype = S.getScalar()->getScalarType();
+        if(stype==pvd::pvString)
+            return sizeof(std::string) + static_cast<const pvd::PVString&>(fld).get().size();
+        return pvd::ScalarTypeFunc::elementSize(stype);
+    }
+    case pvd::scalarArray: {
+        const pvd::PVScalarArray& A = static_cast<const pvd::PVScalarArray&>(fld);
+        pvd::ScalarType stype = A.getScalarArray()->getElementType();
+        if(stype==pvd::pvString) {
+            pvd::PVStringArray::const_svector arr(static_cast<const pvd::PVStringArray&>(fld).view());
+            size_t ret = arr.size()*sizeof(std::string);
+            for(size_t i=0, N=arr.size(); i<N; i++)
+                ret += arr[i].size();
+            return ret;
+        }
+        return A.getLength()*pvd::ScalarTypeFunc::elementSize(stype);
+    }
+    case pvd::structure: {
+        const pvd::PVFieldPtrArray& flds = static_cast<const pvd::PVStructure&>(fld).getPVFields();
+        size_t ret = 0u;
+        for(size_t i=0, N=flds.size(); i<N; i++)
+            ret += GWSizeOf(*flds[i]);
+        return ret;
+    }
+    case pvd::structureArray: {
+        pvd::PVStructureArray::const_svector arr(static_cast<const pvd::PVStructureArray&>(fld).view());
+        size_t ret = arr.size()*sizeof(void*);
+        for(size_t i=0, N=arr.size(); i<N; i++) {
+            if(arr[i])
+                ret += GWSizeOf(*arr[i]);
+        }
+        return ret;
+    }
+    case pvd::union_: {
+        pvd::PVField::const_shared_pointer U(static_cast<const pvd::PVUnion&>(fld).get());
+        return U ? GWSizeOf(*U) : 0u;
+    }
+    case pvd::unionArray: {
+        pvd::PVUnionArray::const_svector arr(static_cast<const pvd::PVUnionArray&>(fld).view());
+        size_t ret = arr.size()*sizeof(void*);
+        for(size_t i=0, N=arr.size(); i<N; i++) {
+            if(arr[i])
+                ret += GWSizeOf(*arr[i]);
+        }
+        return ret;
+    }
+    }
+    return 0u;
+}
+
+void GWSizeCache::reset()
+{
+    bytes.clear();
+    total = 0u;
+}
+
+size_t GWSizeCache::update(const pvd::PVStructure& root, const pvd::BitSet& mask)
+{
+    const size_t N = root.getNumberFields();
+    const bool all = bytes.size()!=N;
+    if(all) {
+        bytes.assign(N, 0u);
+        total = 0u;
+    }
+
+    for(pvd::int32 bit = all ? 0 : mask.nextSetBit(0); bit>=0 && size_t(bit)<N; ) {
+        const size_t end = all ? N : (bit==0 ? N : root.getSubFieldT(bit)->getNextFieldOffset());
+
+        for(size_t off=bit; off<end; off++) {
+            total -= bytes[off];
+            if(off==0) {
+                bytes[off] = 0u;
+            } else {
+                pvd::PVFieldPtr fld(root.getSubFieldT(off));
+                bytes[off] = fld->getField()->getType()==pvd::structure ? 0u : GWSizeOf(*fld);
+            }
+            total += bytes[off];
+        }
+
+        if(end>=N)
+            break;
+        bit = all ? pvd::int32(end) : mask.nextSetBit(end);
+    }
+    return total;
+}
+
 GWChan::Requester::Requester()
     :poked(true)
 {
@@ -157,15 +252,52 @@ void GWChan::getField(pva::GetFieldRequester::shared_pointer const & requester,s
     return us_channel->getField(requester, subField);
 }
 
-GWMon::Requester::Requester(const std::string &usname)
+GWMon::Requester::Requester(const std::string &usname, const std::tr1::shared_ptr<GWProvider>& provider)
     :name(usname)
+    ,provider(provider)
+    ,completeBytes(0u)
 {
     REFTRACE_INCREMENT(num_instances);
 }
 GWMon::Requester::~Requester() {
+    account(0u);
     REFTRACE_DECREMENT(num_instances);
 }
 
+void GWMon::Requester::account(size_t newsize)
+{
+    if(newsize==completeBytes)
+        return;
+
+    GWProvider::shared_pointer prov(provider.lock());
+    if(prov) {
+        epics::atomic::add(prov->memCache, newsize);
+        epics::atomic::subtract(prov->memCache, completeBytes);
+    }
+    completeBytes = newsize;
+}
+
+size_t GWMon::Requester::queueBytes()
+{
+    strong_t mons;
+    size_t elemBytes;
+    {
+        Guard G(mutex);
+        latch(mons);
+        elemBytes = completeBytes;
+    }
+
+    // assume each queued update is a complete copy.
+    // an over-estimate as array storage will often be shared with 'complete'.
+    size_t ret = 0u;
+    for(size_t i=0, N=mons.size(); i<N; i++) {
+        pva::Monitor::Stats S;
+        mons[i]->getStats(S);
+        ret += (S.nfilled + S.noutstanding)*elemBytes;
+    }
+    return ret;
+}
+
 void GWMon::Requester::latch(strong_t& mons)
 {
     mons.clear();
@@ -212,9 +344,13 @@ void GWMon::Requester::monitorConnect(pvd::Status const & status,
         valid.clear();
         if(status.isSuccess() && container) {
             complete = container;
+            completeSize.reset();
+            account(completeSize.update(*container, valid));
         } else {
             TRACE(status<<" no Initial?!?");
             complete.reset();
+            completeSize.reset();
+            account(0u);
             return;
         }
     }
@@ -235,6 +371,7 @@ void GWMon::Requester::monitorEvent(pva::MonitorPtr const & monitor)
     }
     TRACE(mons.size());
 
+    pvd::BitSet changed;
     for(pvd::MonitorElement::Ref it(monitor); it; ++it)
     {
         pva::MonitorElement& elem(*it);
@@ -249,9 +386,17 @@ void GWMon::Requester::monitorEvent(pva::MonitorPtr const & monitor)
             complete->copyUnchecked(*elem.pvStructurePtr,
                                     *elem.changedBitSet);
             valid |= *elem.changedBitSet;
+            changed |= *elem.changedBitSet;
         }
     }
 
+    if(complete) {
+        // only changed fields are re-sized
+        size_t newsize = completeSize.update(*complete, changed);
+        Guard G(mutex);
+        account(newsize);
+    }
+
     for(size_t i=0, N=mons.size(); i<N; i++) {
         mons[i]->notify();
     }
@@ -340,8 +485,7 @@ pva::Monitor::shared_pointer GWChan::createMonitor(pva::MonitorRequester::shared
         key = strm.str();
     }
 
-    GWMon::shared_pointer ret(new GWMon(name, requester, pvRequest));
-    ret->channel = shared_from_this();
+    const bool memok = provider->checkMemory();
 
     GWMon::Requester::shared_pointer entry;
     bool create;
@@ -355,12 +499,21 @@ pva::Monitor::shared_pointer GWChan::createMonitor(pva::MonitorRequester::shared
         }
 
         create = !entry;
-        if(create) {
-            entry.reset(new GWMon::Requester(usname));
+        if(create && memok) {
+            entry.reset(new GWMon::Requester(usname, provider));
             provider->monitors[key] = entry;
         }
     }
 
+    if(!entry) {
+        TRACE("ERROR memory limit");
+        requester->monitorConnect(pvd::Status::error("Gateway memory limit exceeded"), pvd::MonitorPtr(), pvd::StructureConstPtr());
+        return pvd::MonitorPtr();
+    }
+
+    GWMon::shared_pointer ret(new GWMon(name, requester, pvRequest));
+    ret->channel = shared_from_this();
+
     pvd::PVStructurePtr initial;
     pvd::BitSet ivalid;
     {
@@ -391,12 +544,16 @@ pva::Monitor::shared_pointer GWChan::createMonitor(pva::MonitorRequester::shared
 ProxyGet::Requester::Requester(const std::tr1::shared_ptr<struct GWChan>& channel)
     :channel(channel)
     ,state(Disconnected)
+    ,lastBytes(0u)
 {
     REFTRACE_INCREMENT(num_instances);
 }
 
 ProxyGet::Requester::~Requester()
 {
+    GWProvider::shared_pointer prov(channel->provider.lock());
+    if(prov)
+        epics::atomic::subtract(prov->memCache, lastBytes);
     REFTRACE_DECREMENT(num_instances);
 }
 
@@ -534,6 +691,18 @@ void ProxyGet::Requester::getDone(const pvd::Status& status,
         GWProvider::shared_pointer prov(channel->provider);
         if(!prov)
             return; // assume shutdown in progress
+
+        if(status.isSuccess() && pvStructure) {
+            // the upstream op re-uses its structure.  Unmarked fields are as sized after the last get.
+            if(sizeRoot.lock()!=pvStructure) {
+                sizeRoot = pvStructure;
+                lastSize.reset();
+            }
+            size_t newsize = bitSet ? lastSize.update(*pvStructure, *bitSet) : GWSizeOf(*pvStructure);
+            epics::atomic::add(prov->memCache, newsize);
+            epics::atomic::subtract(prov->memCache, lastBytes);
+            lastBytes = newsize;
+        }
         // schedule holdoff timer
         double wait = epics::atomic::get(channel->get_holdoff)/1000.0;
         if(wait>0) {
@@ -693,6 +862,8 @@ pva::ChannelGet::shared_pointer GWChan::createChannelGet(
         key = strm.str();
     }
 
+    const bool memok = provider->checkMemory();
+
     ProxyGet::Requester::shared_pointer entry;
     bool create;
     {
@@ -705,12 +876,18 @@ pva::ChannelGet::shared_pointer GWChan::createChannelGet(
         }
 
         create = !entry;
-        if(create) {
+        if(create && memok) {
             entry.reset(new ProxyGet::Requester(shared_from_this()));
             provider->gets[key] = entry;
         }
     }
 
+    if(!entry) {
+        TRACE("ERROR memory limit");
+        requester->channelGetConnect(pvd::Status::error("Gateway memory limit exceeded"), pva::ChannelGet::shared_pointer(), pvd::StructureConstPtr());
+        return pva::ChannelGet::shared_pointer();
+    }
+
     ProxyGet::shared_pointer ret(new ProxyGet(entry, requester, pvRequest));
 
     pvd::Status sts;
@@ -1018,6 +1195,83 @@ GWChan::createChannelRPC(
     return op;
 }
 
+GWBanCache::GWBanCache()
+    :limit(100000u)
+    ,ttl(0.0)
+    ,hits(0u)
+    ,evictions(0u)
+{}
+
+bool GWBanCache::test(const std::string& key, const epicsTime& now)
+{
+    if(!forced.empty() && forced.find(key)!=forced.end()) {
+        hits++;
+        return true;
+    }
+
+    index_t::iterator it(index.find(key));
+    if(it==index.end())
+        return false;
+
+    if(ttl>0.0 && it->second->expires <= now) {
+        evict(it);
+        return false;
+    }
+
+    // move to front
+    lru.splice(lru.begin(), lru, it->second);
+    hits++;
+    return true;
+}
+
+void GWBanCache::insert(const std::string& key, const epicsTime& now)
+{
+    if(forced.find(key)!=forced.end())
+        return;
+
+    index_t::iterator it(index.find(key));
+    if(it!=index.end()) {
+        // renew
+        lru.splice(lru.begin(), lru, it->second);
+
+    } else {
+        if(limit) {
+            while(index.size()>=limit)
+                evict(index.find(lru.back().key));
+        }
+
+        lru.push_front(Entry());
+        lru.front().key = key;
+        it = index.insert(std::make_pair(key, lru.begin())).first;
+    }
+    if(ttl>0.0)
+        it->second->expires = now + ttl;
+}
+
+void GWBanCache::force(const std::string& key)
+{
+    index_t::iterator it(index.find(key));
+    if(it!=index.end()) {
+        lru.erase(it->second);
+        index.erase(it);
+    }
+    forced.insert(key);
+}
+
+void GWBanCache::clear()
+{
+    lru.clear();
+    index.clear();
+    forced.clear();
+}
+
+void GWBanCache::evict(index_t::iterator it)
+{
+    lru.erase(it->second);
+    index.erase(it);
+    evictions++;
+}
+
 pva::ChannelProvider::shared_pointer GWProvider::buildClient(const std::string& name,const pva::Configuration::shared_pointer& conf)
 {
     return pva::ChannelProviderRegistry::clients()->createProvider(name, conf);
@@ -1039,17 +1293,25 @@ GWProvider::GWProvider(const std::string& name,
                        const pva::ChannelProvider::shared_pointer& provider)
     :name(name)
     ,client(provider)
+    ,memCache(0u)
+    ,memLimit(0u)
     ,prevtime(epicsTime::getCurrent())
     ,audit_run(true)
     ,audit_runner(pvd::Thread::Config(this, &GWProvider::runAudit)
                   .name("GW Auditor")
                   .autostart(false))
+    ,search_batch(0)
+    ,search_run(true)
+    ,search_runner(pvd::Thread::Config(this, &GWProvider::runSearch)
+                   .name("GW Searcher")
+                   .autostart(false))
     ,timerQueue("GW timers", (pvd::ThreadPriority)epicsThreadPriorityMedium  )
     ,handle(0)
 {
     REFTRACE_INCREMENT(num_instances);
     TRACE("");
     audit_runner.start();
+    search_runner.start();
 }
 
 GWProvider::~GWProvider() {
@@ -1062,15 +1324,36 @@ GWProvider::~GWProvider() {
     audit_holdoff.signal();
     audit_runner.exitWait();
 
+    {
+        Guard G(search_mutex);
+        search_run = false;
+    }
+    search_wakeup.signal();
+    search_holdoff.signal();
+    search_runner.exitWait();
+
     GWProvider_cleanup(this);
     REFTRACE_DECREMENT(num_instances);
 }
 
 GWSearchResult GWProvider::test(const std::string& usname)
 {
-    bool connected;
+    Guard G(mutex);
+    return testLocked(usname);
+}
+
+void GWProvider::test(const std::vector<std::string>& usnames, std::vector<int>& results)
+{
+    results.resize(usnames.size());
 
     Guard G(mutex);
+    for(size_t i=0, N=usnames.size(); i<N; i++)
+        results[i] = testLocked(usnames[i]);
+}
+
+GWSearchResult GWProvider::testLocked(const std::string& usname)
+{
+    bool connected;
 
     channels_t::iterator it(channels.find(usname));
 
@@ -1152,50 +1435,115 @@ std::string GWProvider::getProviderName() { return name; }
 pva::ChannelFind::shared_pointer GWProvider::channelFind(std::string const & name,
                                                          pva::ChannelFindRequester::shared_pointer const & requester)
 {
-    GWSearchResult result = GWSearchClaim;
-    pvd::Status sts;
     pva::PeerInfo::const_shared_pointer peer(requester->getPeerInfo());
-    std::string peerHost;
+
+    search_queue_t searches(1);
+    searches[0].name = name;
+    if(peer)
+        searches[0].peer = peer->peer;
+    searches[0].requester = requester;
+
+    if(epics::atomic::get(search_batch)) {
+        // defer to runSearch().  pvAccess calls channelFind() for each name of a search message in turn,
+        // so runSearch() holds off briefly to collect the rest.
+        bool wake;
+        {
+            Guard G(search_mutex);
+            wake = search_queue.empty();
+            search_queue.push_back(searches[0]);
+        }
+        if(wake)
+            search_wakeup.signal();
+        return dummyFind;
+    }
+
+    std::vector<int> results;
+    searchBatch(searches, results);
+
+    TRACE(name<<" "<<results[0]);
+    requester->channelFindResult(pvd::Status(), dummyFind, results[0]==GWSearchClaim);
+    return dummyFind;
+}
+
+void GWProvider::searchBatch(const search_queue_t& searches, std::vector<int>& results)
+{
+    const size_t N = searches.size();
+    results.assign(N, GWSearchClaim);
+
+    std::vector<std::string> peerHosts(N), hostPVs(N);
+    for(size_t i=0; i<N; i++) {
+        peerHosts[i] = searches[i].peer.substr(0, searches[i].peer.find_first_of(':'));
+        hostPVs[i] = peerHosts[i]+'\n'+searches[i].name;
+    }
+    const epicsTime now(epicsTime::getCurrent());
 
     // Test negative result cache
     {
         Guard G(mutex);
-        if(banPV.find(name)!=banPV.end()) {
-            result = GWSearchIgnore;
+        for(size_t i=0; i<N; i++) {
+            if(banPV.test(searches[i].name, now)
+                    || banHost.test(peerHosts[i], now)
+                    || banHostPV.test(hostPVs[i], now))
+            {
+                TRACE("Ignore Banned "<<searches[i].name<<" from "<<peerHosts[i]);
+                results[i] = GWSearchIgnore;
+            }
+        }
+    }
+
+    // group remaining by peer, for one upcall each
+    typedef std::map<std::string, std::vector<size_t> > bypeer_t;
+    bypeer_t bypeer;
+    for(size_t i=0; i<N; i++) {
+        if(results[i]==GWSearchClaim)
+            bypeer[searches[i].peer].push_back(i);
+    }
+
+    bool banned = false;
+    for(bypeer_t::const_iterator it(bypeer.begin()), end(bypeer.end()); it!=end; ++it) {
+        const std::vector<size_t>& idx = it->second;
+
+        if(idx.size()==1u) {
+            TRACE("Check "<<searches[idx[0]].name<<" for "<<it->first);
+            results[idx[0]] = GWProvider_testChannel(this, searches[idx[0]].name.c_str(), it->first.c_str());
+
         } else {
-            if(peer)
-                peerHost = peer->peer.substr(0, peer->peer.find_first_of(':'));
+            std::vector<std::string> names(idx.size());
+            for(size_t n=0; n<idx.size(); n++)
+                names[n] = searches[idx[n]].name;
 
-            if(banHost.find(peerHost)!=banHost.end()
-                    || banHostPV.find(std::make_pair(peerHost, name))!=banHostPV.end())
-                result = GWSearchIgnore;
+            TRACE("Check "<<names.size()<<" for "<<it->first);
+            std::vector<int> R;
+            GWProvider_testChannels(this, names, it->first.c_str(), R);
+
+            for(size_t n=0; n<idx.size(); n++)
+                results[idx[n]] = n<R.size() ? R[n] : GWSearchBanHost;
         }
-        if(result!=GWSearchClaim)
-            TRACE("Ignore Banned "<<name<<" from "<<peerHost<<" "<<result);
-    }
 
-    if(result==GWSearchClaim) {
-        TRACE("Check "<<name<<" for "<<peerHost);
-        result = (GWSearchResult)GWProvider_testChannel(this, name.c_str(), peer ? peer->peer.c_str() : "");
+        for(size_t n=0; n<idx.size(); n++)
+            banned |= results[idx[n]]>GWSearchClaim;
     }
 
-    if(result>GWSearchClaim) {
+    if(banned) {
         Guard G(mutex);
-        if(result==GWSearchBanPV) {
-            TRACE("Ban PV "<<name);
-            banPV.insert(name);
-        } else if(result==GWSearchBanHost) {
-            TRACE("Ban Host "<<peerHost);
-            banHost.insert(peerHost);
-        } else if(result==GWSearchBanHostPV) {
-            TRACE("Ban Host+PV "<<peerHost<<" "<<name);
-            banHostPV.insert(std::make_pair(peerHost, name));
+        for(size_t i=0; i<N; i++) {
+            if(results[i]==GWSearchBanPV) {
+                TRACE("Ban PV "<<searches[i].name);
+                banPV.insert(searches[i].name, now);
+            } else if(results[i]==GWSearchBanHost) {
+                TRACE("Ban Host "<<peerHosts[i]);
+                banHost.insert(peerHosts[i], now);
+            } else if(results[i]==GWSearchBanHostPV) {
+                TRACE("Ban Host+PV "<<peerHosts[i]<<" "<<searches[i].name);
+                banHostPV.insert(hostPVs[i], now);
+            }
         }
     }
+}
 
-    TRACE(name<<" "<<result);
-    requester->channelFindResult(sts, dummyFind, result==GWSearchClaim);
-    return dummyFind;
+void GWProvider::setSearchBatching(bool batch)
+{
+    epics::atomic::set(search_batch, batch ? 1 : 0);
 }
 
 pva::ChannelFind::shared_pointer GWProvider::channelList(pva::ChannelListRequester::shared_pointer const & requester)
@@ -1289,13 +1637,13 @@ void GWProvider::forceBan(const std::string& host, const std::string& usname)
     Guard G(mutex);
 
     if(!host.empty() && !usname.empty()) {
-        banHostPV.insert(std::make_pair(host, usname));
+        banHostPV.force(host+'\n'+usname);
 
     } else if(!host.empty()) {
-        banHost.insert(host);
+        banHost.force(host);
 
     } else if(!usname.empty()) {
-        banPV.insert(usname);
+        banPV.force(usname);
     }
 }
 
@@ -1307,6 +1655,13 @@ void GWProvider::clearBan()
     banHostPV.clear();
 }
 
+void GWProvider::setBanLimits(size_t limit, double ttl)
+{
+    Guard G(mutex);
+    banHost.limit = banPV.limit = banHostPV.limit = limit;
+    banHost.ttl = banPV.ttl = banHostPV.ttl = ttl;
+}
+
 void GWProvider::cachePeek(std::set<std::string>& names) const
 {
     names.clear();
@@ -1318,14 +1673,133 @@ void GWProvider::cachePeek(std::set<std::string>& names) const
 
 void GWProvider::stats(GWStats& stats) const
 {
-    Guard G(mutex);
+    std::vector<GWMon::Requester::shared_pointer> mons;
+    {
+        Guard G(mutex);
+
+        stats.ccacheSize = channels.size();
+        stats.mcacheSize = monitors.size();
+        stats.gcacheSize = gets.size();
+        stats.banHostSize = banHost.size();
+        stats.banPVSize = banPV.size();
+        stats.banHostPVSize = banHostPV.size();
+        stats.banHits = banHost.hits + banPV.hits + banHostPV.hits;
+        stats.banEvictions = banHost.evictions + banPV.evictions + banHostPV.evictions;
+
+        mons.reserve(monitors.size());
+        for(monitors_t::const_iterator it(monitors.begin()), end(monitors.end()); it!=end; ++it)
+        {
+            GWMon::Requester::shared_pointer M(it->second.lock());
+            if(M)
+                mons.push_back(M);
+        }
+    }
 
-    stats.ccacheSize = channels.size();
-    stats.mcacheSize = monitors.size();
-    stats.gcacheSize = gets.size();
-    stats.banHostSize = banHost.size();
-    stats.banPVSize = banPV.size();
-    stats.banHostPVSize = banHostPV.size();
+    stats.memCache = epics::atomic::get(memCache);
+    stats.memLimit = epics::atomic::get(memLimit);
+    stats.memQueue = 0u;
+    for(size_t i=0; i<mons.size(); i++)
+        stats.memQueue += mons[i]->queueBytes();
+}
+
+void GWProvider::setMemoryLimit(size_t limit)
+{
+    epics::atomic::set(memLimit, limit);
+}
+
+namespace {
+struct IdleGet {
+    size_t bytes;
+    GWProvider::gets_t::iterator it;
+    bool operator<(const IdleGet& o) const {
+        return bytes > o.bytes; // largest first
+    }
+};
+}
+
+bool GWProvider::checkMemory()
+{
+    const size_t limit = epics::atomic::get(memLimit);
+    size_t cur = epics::atomic::get(memCache);
+    if(!limit || cur<=limit)
+        return true;
+
+    // evict idle GET cache entries, largest first.
+    // monitor cache entries are never idle as they expire with their last subscriber.
+    std::vector<ProxyGet::Requester::shared_pointer> garbage;
+    {
+        Guard G(mutex);
+
+        std::vector<IdleGet> idle;
+        for(gets_t::iterator it(gets.begin()), end(gets.end()); it!=end; ++it) {
+            if(!it->second.unique())
+                continue;
+            IdleGet ent;
+            {
+                Guard G2(it->second->mutex);
+                ent.bytes = it->second->lastBytes;
+            }
+            ent.it = it;
+            idle.push_back(ent);
+        }
+
+        std::sort(idle.begin(), idle.end());
+
+        for(size_t i=0; i<idle.size() && cur>limit; i++) {
+            TRACE("Evict GET cache entry "<<idle[i].it->first<<" "<<idle[i].bytes);
+            cur -= std::min(cur, idle[i].bytes);
+            garbage.push_back(idle[i].it->second);
+            gets.erase(idle[i].it);
+        }
+    }
+    // garbage free'd after unlock
+
+    return cur<=limit;
+}
+
+void GWProvider::memoryReport(memory_report_t& report) const
+{
+    report.clear();
+
+    std::vector<GWMon::Requester::shared_pointer> mons;
+    std::vector<ProxyGet::Requester::shared_pointer> getters;
+    {
+        Guard G(mutex);
+        mons.reserve(monitors.size());
+        for(monitors_t::const_iterator it(monitors.begin()), end(monitors.end()); it!=end; ++it)
+        {
+            GWMon::Requester::shared_pointer M(it->second.lock());
+            if(M)
+                mons.push_back(M);
+        }
+        getters.reserve(gets.size());
+        for(gets_t::const_iterator it(gets.begin()), end(gets.end()); it!=end; ++it)
+            getters.push_back(it->second);
+    }
+
+    // one entry per upstream PV name
+    typedef std::map<std::string, MemoryItem> items_t;
+    items_t items;
+
+    for(size_t i=0; i<mons.size(); i++) {
+        MemoryItem& ent = items[mons[i]->name];
+        ent.queue += mons[i]->queueBytes();
+        Guard G(mons[i]->mutex);
+        ent.cache += mons[i]->completeBytes;
+        ent.nds += mons[i]->ds_ops.size();
+    }
+
+    for(size_t i=0; i<getters.size(); i++) {
+        MemoryItem& ent = items[getters[i]->channel->us_channel->getChannelName()];
+        Guard G(getters[i]->mutex);
+        ent.get += getters[i]->lastBytes;
+    }
+
+    report.reserve(items.size());
+    for(items_t::iterator it(items.begin()), end(items.end()); it!=end; ++it) {
+        report.push_back(it->second);
+        report.back().usname = it->first;
+    }
 }
 
 namespace {
@@ -1448,6 +1922,54 @@ void GWProvider::runAudit()
     }
 }
 
+void GWProvider::runSearch()
+{
+    search_queue_t searches;
+    std::vector<int> results;
+
+    Guard G(search_mutex);
+    while(search_run) {
+        if(search_queue.empty()) {
+            UnGuard U(G);
+            search_wakeup.wait();
+            continue;
+        }
+
+        {
+            UnGuard U(G);
+            // the first name of a search message has been queued.
+            // wait a bounded time for channelFind() to be called with the remainder.
+            search_holdoff.wait(0.002);
+        }
+
+        searches.swap(search_queue); // take all queued
+
+        {
+            UnGuard U(G);
+
+            pvd::Status sts;
+            try {
+                searchBatch(searches, results);
+            }catch(std::exception& e){
+                errlogPrintf("GW Searcher unhandled exception: %s\n", e.what());
+                sts = pvd::Status::error(e.what());
+                results.assign(searches.size(), GWSearchIgnore);
+            }
+
+            // every requester gets a reply
+            for(size_t i=0, N=searches.size(); i<N; i++) {
+                TRACE(searches[i].name<<" "<<results[i]);
+                try {
+                    searches[i].requester->channelFindResult(sts, dummyFind, results[i]==GWSearchClaim);
+                }catch(std::exception& e){
+                    errlogPrintf("GW Searcher unhandled exception: %s\n", e.what());
+                }
+            }
+            searches.clear(); // release requesters while unlocked
+        }
+    }
+}
+
 #ifdef TRACING
 std::ostream& show_time(std::ostream& strm)
 {
@@ -5,6 +5,18 @@
 #include <list>
 #include <set>
 
+#if __cplusplus>=201103L || (defined(_MSC_VER) && _MSC_VER>=1600)
+#  include <unordered_map>
+#  include <unordered_set>
+#  define GW_UNORDERED_MAP std::unordered_map
+#  define GW_UNORDERED_SET std::unordered_set
+#else
+#  include <tr1/unordered_map>
+#  include <tr1/unordered_set>
+#  define GW_UNORDERED_MAP std::tr1::unordered_map
+#  define GW_UNORDERED_SET std::tr1::unordered_set
+#endif
+
 #include <Python.h>
 
 #include <epicsMutex.h>
@@ -53,6 +65,26 @@ namespace pva = epics::pvAccess;
 void GWInstallClientAliased(const pva::ChannelProvider::shared_pointer& provider,
                             const std::string& installAs);
 
+// Estimate of the bytes of storage used by a PVField (and any sub-fields).
+// Array storage is counted in full, even when shared with other containers.
+size_t GWSizeOf(const pvd::PVField& fld);
+
+// GWSizeOf() of a PVStructure, kept up to date by re-visiting only changed fields.
+struct GWSizeCache {
+    // GWSizeOf() of each leaf field, indexed by field offset.  Zero for sub-structures.
+    std::vector<size_t> bytes;
+    size_t total;
+
+    GWSizeCache() :total(0u) {}
+
+    // forget all, so that the next update() visits every field
+    void reset();
+    // Re-size fields marked in 'mask' (and any sub-fields), which have been changed in 'root'.
+    // Visits every field after reset(), or if the number of fields is not as before.
+    // Returns the new total.
+    size_t update(const pvd::PVStructure& root, const pvd::BitSet& mask);
+};
+
 struct GWProvider;
 
 struct GWChan : public pva::Channel,
@@ -149,6 +181,8 @@ struct GWMon : public pva::MonitorFIFO
         static size_t num_instances;
 
         const std::string name;
+        // provider through which we were created, for memory accounting
+        const std::tr1::weak_ptr<GWProvider> provider;
 
         mutable epicsMutex mutex;
 
@@ -161,14 +195,23 @@ struct GWMon : public pva::MonitorFIFO
 
         pvd::PVStructure::shared_pointer complete;
         pvd::BitSet valid;
+        // GWSizeOf(*complete), and our contribution to GWProvider::memCache
+        size_t completeBytes;
+        // per-field sizes of 'complete'.  Only accessed from monitor callbacks.
+        GWSizeCache completeSize;
 
         pva::NetStats::Stats prevStats;
 
-        explicit Requester(const std::string& usname);
+        Requester(const std::string& usname, const std::tr1::shared_ptr<GWProvider>& provider);
         virtual ~Requester();
 
         void latch(strong_t& mons);
 
+        // update completeBytes, and GWProvider::memCache.  Call with mutex locked
+        void account(size_t newsize);
+        // estimate bytes queued by all downstream subscriptions
+        size_t queueBytes();
+
         virtual std::string getRequesterName() OVERRIDE FINAL;
         virtual void channelDisconnect(bool destroy) OVERRIDE FINAL;
         virtual void monitorConnect(pvd::Status const & status,
@@ -244,6 +287,13 @@ struct ProxyGet : public pva::ChannelGet,
         // state==Disconnected implies !type
         pvd::Structure::const_shared_pointer type;
 
+        // size of last upstream getDone() result, which the upstream op retains.
+        // our contribution to GWProvider::memCache
+        size_t lastBytes;
+        // per-field sizes of the last result, and the structure they describe.  Guarded by mutex
+        GWSizeCache lastSize;
+        pvd::PVStructure::weak_pointer sizeRoot;
+
         explicit Requester(const std::tr1::shared_ptr<struct GWChan>& channel);
         virtual ~Requester();
 
@@ -415,6 +465,46 @@ struct ProxyRPC : public pva::ChannelRPC,
     EPICS_NOT_COPYABLE(ProxyRPC)
 };
 
+// Negative search result cache.
+// Entries added from search results are bounded in number, with least recently
+// used evicted first, and optionally expire after a fixed time.
+// Forced entries (see GWProvider::forceBan()) are never evicted.
+// Not thread-safe.  Caller must serialize.
+struct GWBanCache {
+    // max # of (non-forced) entries.  zero for unlimited.  (default 100000)
+    size_t limit;
+    // entry lifetime in seconds.  <=0 for no expiration
+    double ttl;
+
+    size_t hits,
+           evictions;
+
+    GWBanCache();
+
+    bool test(const std::string& key, const epicsTime& now);
+    void insert(const std::string& key, const epicsTime& now);
+    void force(const std::string& key);
+    void clear();
+
+    size_t size() const { return index.size() + forced.size(); }
+
+private:
+    struct Entry {
+        std::string key;
+        epicsTime expires;
+    };
+    // most recently used at front
+    typedef std::list<Entry> lru_t;
+    typedef GW_UNORDERED_MAP<std::string, lru_t::iterator> index_t;
+    typedef GW_UNORDERED_SET<std::string> forced_t;
+
+    lru_t lru;
+    index_t index;
+    forced_t forced;
+
+    void evict(index_t::iterator it);
+};
+
 enum GWSearchResult {
     GWSearchIgnore,
     GWSearchClaim,
@@ -430,6 +520,12 @@ struct GWStats {
            banHostSize,
            banPVSize,
            banHostPVSize;
+    size_t banHits,
+           banEvictions;
+    // bytes
+    size_t memCache,
+           memQueue,
+           memLimit;
 };
 
 struct GWProvider : public pva::ChannelProvider,
@@ -449,10 +545,9 @@ struct GWProvider : public pva::ChannelProvider,
 
     mutable epicsMutex mutex;
 
-    typedef std::set<std::string> ban_t;
-    ban_t banHost,
-          banPV;
-    std::set<std::pair<std::string, std::string> > banHostPV;
+    GWBanCache banHost,
+               banPV,
+               banHostPV; // key is host+'\n'+pvname
 
     typedef std::map<std::string, std::tr1::shared_ptr<GWChan::Requester> > channels_t;
     channels_t channels;
@@ -463,6 +558,13 @@ struct GWProvider : public pva::ChannelProvider,
     typedef std::map<std::string, std::tr1::shared_ptr<ProxyGet::Requester> > gets_t;
     gets_t gets;
 
+    // Use atomic access.
+    // Estimated bytes held by cached monitor values and GET results
+    size_t memCache;
+    // When non-zero, limit on memCache beyond which idle GET cache entries
+    // are evicted, and new upstream monitor/get are refused.
+    size_t memLimit;
+
     epicsTime prevtime;
 
     typedef std::list<std::string> audit_log_t;
@@ -472,6 +574,26 @@ struct GWProvider : public pva::ChannelProvider,
 
     pvd::Thread audit_runner;
 
+    // searches awaiting batch evaluation by runSearch()
+    struct PendingSearch {
+        std::string name,
+                    peer;
+        pva::ChannelFindRequester::shared_pointer requester;
+    };
+    typedef std::vector<PendingSearch> search_queue_t;
+
+    // Use atomic access.
+    // binary flag.  When set, channelFind() defers to runSearch()
+    int search_batch;
+
+    // guards search_queue and search_run
+    mutable epicsMutex search_mutex;
+    search_queue_t search_queue;
+    epicsEvent search_wakeup, search_holdoff;
+    bool search_run;
+
+    pvd::Thread search_runner;
+
     pvd::Timer timerQueue;
 
     // guarded by GIL
@@ -486,6 +608,12 @@ public:
     static pva::ChannelProvider::shared_pointer buildClient(const std::string& name, const pva::Configuration::shared_pointer& conf);
 
     GWSearchResult test(const std::string& usname);
+    // test() a list of names with one lock.  results[i] corresponds to usnames[i]
+    void test(const std::vector<std::string>& usnames, std::vector<int>& results);
+
+    // Enable evaluation of names searched within a short holdoff (eg. from one search message)
+    // together with one GWProvider_testChannels() upcall per peer.
+    void setSearchBatching(bool batch);
 
     GWChan::shared_pointer connect(const std::string& dsname,
                                    const std::string& usname,
@@ -504,11 +632,29 @@ public:
     void disconnect(const std::string& usname);
     void forceBan(const std::string& host, const std::string& usname);
     void clearBan();
+    // Apply to all negative result caches.
+    void setBanLimits(size_t limit, double ttl);
 
     void cachePeek(std::set<std::string> &names) const;
 
     void stats(GWStats& stats) const;
 
+    void setMemoryLimit(size_t limit);
+    // true if below memLimit, after evicting idle entries if necessary
+    bool checkMemory();
+
+    struct MemoryItem {
+        std::string usname;
+        size_t cache, // GWMon::Requester::complete
+               queue, // downstream GWMon queues
+               get;   // ProxyGet::Requester::lastBytes
+        size_t nds;   // # of downstream subscriptions
+        MemoryItem() :cache(0u), queue(0u), get(0u), nds(0u) {}
+    };
+    typedef std::vector<MemoryItem> memory_report_t;
+
+    void memoryReport(memory_report_t& report) const;
+
     struct ReportItem {
         std::string usname,
                     dsname;
@@ -524,7 +670,14 @@ public:
     static void prepare();
 
 private:
+    GWSearchResult testLocked(const std::string& usname);
+
+    // apply negative result cache, then GWProvider_testChannel*(), then update cache.
+    // results[i] corresponds to searches[i].
+    void searchBatch(const search_queue_t& searches, std::vector<int>& results);
+
     void runAudit();
+    void runSearch();
 
     EPICS_NOT_COPYABLE(GWProvider)
 };
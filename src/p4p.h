@@ -192,6 +192,7 @@ void p4p_server_register(PyObject *mod);
 void p4p_server_sharedpv_register(PyObject *mod);
 void p4p_array_register(PyObject *mod);
 void p4p_client_register(PyObject *mod);
+void p4p_recorder_register(PyObject *mod);
 
 epics::pvAccess::ChannelProvider::shared_pointer p4p_build_provider(PyRef &handler, const std::string& name);
 epics::pvAccess::ChannelProvider::shared_pointer p4p_unwrap_provider(PyObject *provider);
@@ -214,13 +215,105 @@ extern PyTypeObject* P4PArray_type;
 PyObject* P4PArray_make(const array_type& v);
 const array_type& P4PArray_extract(PyObject* o);
 
+// read-only sequence of str, decoded on demand
+typedef epics::pvData::shared_vector<const std::string> string_array_type;
+extern PyTypeObject* P4PStringArray_type;
+PyObject* P4PStringArray_make(const string_array_type& v);
+const string_array_type& P4PStringArray_extract(PyObject* o);
+
 extern PyTypeObject* P4PValue_type;
+// Extract PVStructure from P4PValue.  Copied first if shared, so the caller may modify it.
 epics::pvData::PVStructure::shared_pointer P4PValue_unwrap(PyObject *, epics::pvData::BitSet* =0);
 std::tr1::shared_ptr<epics::pvData::BitSet> P4PValue_unwrap_bitset(PyObject *);
 PyObject *P4PValue_wrap(PyTypeObject *type,
                         const epics::pvData::PVStructure::shared_pointer&,
                         const epics::pvData::BitSet::shared_pointer& = epics::pvData::BitSet::shared_pointer());
 
+// Free list of PVStructures, all of one Structure, to be re-used when copying.
+// eg. one for each subscription.  May be accessed without the GIL.
+struct P4PStructurePool : public std::tr1::enable_shared_from_this<P4PStructurePool> {
+    epicsMutex lock;
+    // max. number of free PVStructures to keep
+    const size_t limit;
+
+    // guarded by lock.  Number of copy() calls, and how many of those re-used a free PVStructure
+    size_t copies, recycled;
+
+    explicit P4PStructurePool(size_t limit) :limit(limit), copies(0u), recycled(0u) {}
+
+    // Copy 'src' into a free PVStructure (or a new one).
+    // The returned PVStructure is put back on the free list when released,
+    // unless some other reference to it remains.
+    epics::pvData::PVStructure::shared_pointer copy(const epics::pvData::PVStructure& src);
+private:
+    struct Recycle;
+    void put(const epics::pvData::PVStructure::shared_pointer& elem);
+
+    epics::pvData::StructureConstPtr type;
+    std::vector<epics::pvData::PVStructure::shared_pointer> free;
+    EPICS_NOT_COPYABLE(P4PStructurePool)
+};
+
+// Storage of a Value, shared with the Values of its sub-structures.
+// A 'shared' root is referenced elsewhere, and is copied before the first modification.
+// A 'lent' root will be modified elsewhere, and must be detach()'d before that happens.
+struct P4PValueRoot {
+    epics::pvData::PVStructure::shared_pointer root;
+    bool shared, lent;
+    // if set, copy into recycled storage
+    std::tr1::shared_ptr<P4PStructurePool> pool;
+    // subscription update only.  Fields which changed more than once, with only the latest value kept.
+    // NULL if none.
+    epics::pvData::BitSet::shared_pointer overrun;
+
+    explicit P4PValueRoot(const epics::pvData::PVStructure::shared_pointer& root, bool shared=false, bool lent=false)
+        :root(root), shared(shared), lent(lent)
+    {}
+
+    void detach() {
+        if(!shared) return;
+        if(!lent && root.unique()) {
+            // others have since released it
+            shared = false;
+            return;
+        }
+        if(pool) {
+            root = pool->copy(*root);
+        } else {
+            epics::pvData::PVStructure::shared_pointer copy(epics::pvData::getPVDataCreate()->createPVStructure(root->getStructure()));
+            copy->copyUnchecked(*root);
+            root = copy;
+        }
+        shared = lent = false;
+    }
+};
+// Wrap storage without copying.  The caller may detach() a lent root at any time (with GIL locked)
+PyObject *P4PValue_wrap_shared(PyTypeObject *type,
+                               const std::tr1::shared_ptr<P4PValueRoot>&,
+                               const epics::pvData::BitSet::shared_pointer&);
+// Serialized form of a Value.  Introspection, changed mask, then data (all fields, or only those changed)
+std::tr1::shared_ptr<const epics::pvData::Serializable> P4PValue_serializer(PyObject *, bool delta);
+PyObject *P4PValue_deserialize(epics::pvData::ByteBuffer& buf);
+
+// JSON translation of PVStructure (see p4p_json.cpp)
+enum P4PJSONNaN {
+    P4PJSONNaNLiteral, // NaN, Infinity, -Infinity (as python json module)
+    P4PJSONNaNNull,
+    P4PJSONNaNError
+};
+// Append JSON object to 'out'.  If 'mask' is provided, only fields marked changed are included.
+// May throw std::invalid_argument.  Call with GIL locked.
+void p4p_to_json(std::string& out,
+                 const epics::pvData::PVStructure& val,
+                 const epics::pvData::BitSet* mask,
+                 P4PJSONNaN nanpolicy);
+// Assign from JSON object, marking 'changed'.  If 'strict', unknown keys are an error.
+// May throw std::invalid_argument, including for nesting deeper than 256.  Call with GIL locked.
+void p4p_from_json(const char *buf, size_t len,
+                   epics::pvData::PVStructure& val,
+                   epics::pvData::BitSet* changed,
+                   bool strict);
+
 extern PyObject* P4PCancelled;
 
 extern PyTypeObject* P4PSharedPV_type;
@@ -81,6 +81,13 @@ cdef extern from "gwchannel.h" namespace "GWProvider" nogil:
         double operationTX
         double operationRX
 
+    cdef struct MemoryItem:
+        string usname
+        size_t cache
+        size_t queue
+        size_t get
+        size_t nds
+
 cdef extern from "gwchannel.h" nogil:
     void GWInstallClientAliased(shared_ptr[ChannelProvider]& provider, string& installAs) except+
 
@@ -101,6 +108,11 @@ cdef extern from "gwchannel.h" nogil:
         size_t banHostSize
         size_t banPVSize
         size_t banHostPVSize
+        size_t banHits
+        size_t banEvictions
+        size_t memCache
+        size_t memQueue
+        size_t memLimit
 
     enum: GWSearchIgnore
     enum: GWSearchClaim
@@ -119,15 +131,20 @@ cdef extern from "gwchannel.h" nogil:
         shared_ptr[GWProvider] shared_from_this() except+
 
         int test(const string& usname)
+        void test(const vector[string]& usnames, vector[int]& results)
+        void setSearchBatching(bool batch)
         shared_ptr[GWChan] connect(const string &dsname, const string &usname, const shared_ptr[ChannelRequester]& requester) except+
 
         void sweep() except+
         void disconnect(const string& usname) except+
         void forceBan(const string& host, const string& usname) except+
         void clearBan() except+
+        void setBanLimits(size_t limit, double ttl) except+
         void cachePeek(setxx[string]& names) except+
         void stats(GWStats& stats)
         void report(vector[ReportItem]& us, vector[ReportItem]& ds, double& period) except+
+        void setMemoryLimit(size_t limit)
+        void memoryReport(vector[MemoryItem]& report) except+
 
         @staticmethod
         void prepare() except+
@@ -354,6 +371,32 @@ cdef class Provider:
             ret = self.provider.get().test(n)
         return ret
 
+    def testChannels(self, list usnames):
+        """testChannels([usname, ...])
+        Equivalent to calling `testChannel()` for each name,
+        but with a single lock of the channel cache.
+
+        :param list usnames: Upstream (Server side) PV names (bytes)
+        :returns: A list of Claim or Ignore
+        """
+        cdef vector[string] names
+        cdef vector[int] results
+        for usname in usnames:
+            names.push_back(<bytes?>usname)
+        with nogil:
+            self.provider.get().test(names, results)
+        return list(results)
+
+    def setSearchBatching(self, bool batch):
+        """When enabled, search requests are evaluated asynchronously, and all names from a peer
+        which are queued within a short holdoff (eg. from one search message) are passed to a single
+        call of handler.testChannels(pvnames, peer) if defined.
+        Otherwise handler.testChannel(pvname, peer) is called for each name.
+
+        :param bool batch: Enable or disable.  Disabled by default.
+        """
+        self.provider.get().setSearchBatching(batch)
+
     def sweep(self):
         """Call periodically to remove unused `Channel` from channel cache.
         """
@@ -391,6 +434,16 @@ cdef class Provider:
         with nogil:
             self.provider.get().clearBan()
 
+    def setBanLimits(self, size_t limit, double ttl):
+        """Bound the size of each negative results cache.
+        Entries added by `forceBan()` are not counted, and never evicted or expired.
+
+        :param int limit: Max. number of entries in each cache.  Least recently used are evicted first.  Zero for unlimited.
+        :param float ttl: Entry lifetime in seconds.  Zero for no expiration.
+        """
+        with nogil:
+            self.provider.get().setBanLimits(limit, ttl)
+
     def cachePeek(self):
         """Returns PV names in channel cache
 
@@ -421,8 +474,47 @@ cdef class Provider:
             'banHostSize.value':stats.banHostSize,
             'banPVSize.value':stats.banPVSize,
             'banHostPVSize.value':stats.banHostPVSize,
+            'banHits.value':stats.banHits,
+            'banEvictions.value':stats.banEvictions,
+            'memCache.value':stats.memCache,
+            'memQueue.value':stats.memQueue,
+            'memLimit.value':stats.memLimit,
         }
 
+    def setMemoryLimit(self, size_t limit):
+        """Set a limit on the estimated bytes held by cached monitor values and GET results.
+        When exceeded, idle GET cache entries are evicted (largest first),
+        and if still exceeded, requests which would create new upstream
+        monitor or get operations are refused.
+
+        :param int limit: Limit in bytes.  Zero disables.
+        """
+        self.provider.get().setMemoryLimit(limit)
+
+    def memoryReport(self):
+        """Estimated memory usage by upstream PV.
+
+        :returns: A list of tuples
+        :rtype: [(usname, cache, queue, get, nsubscriptions)]
+        """
+        cdef vector[MemoryItem] report
+        cdef MemoryItem item
+
+        with nogil:
+            self.provider.get().memoryReport(report)
+
+        ret = []
+        for item in report:
+            # order in tuple must match column order
+            ret.append((
+                item.usname.decode('UTF-8'),
+                item.cache,
+                item.queue,
+                item.get,
+                item.nds,
+            ))
+        return ret
+
     def report(self):
         """Run bandwidth usage report
 
@@ -499,6 +591,40 @@ cdef public:
             traceback.print_exc()
             return GWSearchBanHost
 
+    void GWProvider_testChannels(GWProvider* provider, const vector[string]& names, const char* peer, vector[int]& results) with gil:
+        cdef size_t i
+        results.clear()
+        if not provider.handle:
+            results.resize(names.size(), GWSearchBanHost)
+            return
+
+        handle = <object>provider.handle
+        upeer = peer.decode('UTF-8')
+        testChannels = getattr(handle, 'testChannels', None)
+
+        if testChannels is None:
+            # fall back to per-name
+            for i in range(names.size()):
+                try:
+                    results.push_back(handle.testChannel(names[i], upeer))
+                except:
+                    import traceback
+                    traceback.print_exc()
+                    results.push_back(GWSearchBanHost)
+            return
+
+        try:
+            ret = testChannels([names[i] for i in range(names.size())], upeer)
+            if len(ret)!=names.size():
+                raise ValueError("testChannels() must return one result per name")
+            for R in ret:
+                results.push_back(R)
+        except:
+            import traceback
+            traceback.print_exc()
+            results.clear()
+            results.resize(names.size(), GWSearchBanHost)
+
     shared_ptr[GWChan] GWProvider_makeChannel(GWProvider* provider, const string& name, const shared_ptr[ChannelRequester]& requester) with gil:
         cdef shared_ptr[GWChan] ret
         cdef CreateOp op
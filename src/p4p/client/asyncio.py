@@ -14,6 +14,7 @@ from ..wrapper import Value, Type
 from .._p4p import (logLevelAll, logLevelTrace, logLevelDebug,
                     logLevelInfo, logLevelWarn, logLevelError,
                     logLevelFatal, logLevelOff)
+from .._p4p import ReadyQueue
 
 __all__ = [
     'Context',
@@ -65,6 +66,12 @@ def timesout(deftimeout=5.0):
     return decorate
 
 
+def _dispatch(ready):
+    # handlers catch and log their own exceptions
+    for handler, args in ready.drain() or []:
+        handler(*args)
+
+
 class Context(raw.Context):
 
     """
@@ -113,6 +120,33 @@ class Context(raw.Context):
         super(Context, self).__init__(provider, conf=conf, useenv=useenv, nt=nt, unwrap=unwrap)
         self.loop = loop or asyncio.get_event_loop()
 
+        try:
+            ready = ReadyQueue()
+            # not a bound method, which would keep this Context alive
+            self.loop.add_reader(ready.fileno(), _dispatch, ready)
+        except NotImplementedError:
+            # eg. on Windows.  Each callback passes through call_soon_threadsafe()
+            pass
+        else:
+            # callbacks from PVA worker threads are queued, and dispatched in batches from the loop
+            self._ready = ready
+
+    def close(self):
+        ready, self._ready = self._ready, None
+        super(Context, self).close()
+        if ready is not None:
+            self.loop.remove_reader(ready.fileno())
+            ready.close()
+            # deliver any final events (eg. Cancelled)
+            for handler, args in ready.drain() or []:
+                self.loop.call_soon(handler, *args)
+
+    def _threadsafe(self, cb):
+        # wrap a callback to be run in the loop
+        if self._ready is None:
+            cb = partial(self.loop.call_soon_threadsafe, cb)
+        return cb
+
     @asyncio.coroutine
     def get(self, name, request=None):
         """Fetch current value of some number of PVs.
@@ -155,7 +189,7 @@ class Context(raw.Context):
                 F.set_exception(value)
             else:
                 F.set_result(value)
-        cb = partial(self.loop.call_soon_threadsafe, cb)
+        cb = self._threadsafe(cb)
 
         op = super(Context, self).get(name, cb, request=request)
 
@@ -224,7 +258,7 @@ class Context(raw.Context):
                 F.set_exception(value)
             else:
                 F.set_result(value)
-        cb = partial(self.loop.call_soon_threadsafe, cb)
+        cb = self._threadsafe(cb)
 
         op = super(Context, self).put(name, cb, builder=value, request=request, get=get)
 
@@ -265,7 +299,7 @@ class Context(raw.Context):
                 F.set_exception(value)
             else:
                 F.set_result(value)
-        cb = partial(self.loop.call_soon_threadsafe, cb)
+        cb = self._threadsafe(cb)
 
         op = super(Context, self).rpc(name, cb, value, request=request)
 
@@ -291,9 +325,10 @@ class Context(raw.Context):
         """
         assert asyncio.iscoroutinefunction(cb), "monitor callback must be coroutine"
         R = Subscription(name, cb, notify_disconnect=notify_disconnect, loop=self.loop)
-        cb = partial(self.loop.call_soon_threadsafe, R._event)
+        cb = self._threadsafe(R._event)
 
-        R._S = super(Context, self).monitor(name, cb, request)
+        # Subscription drains the FIFO after each Data wakeup, so further wakeups are redundant
+        R._S = super(Context, self).monitor(name, cb, request, coalesce=True)
         return R
 
 
@@ -338,6 +373,11 @@ class Subscription(object):
         'Is data pending in event queue?'
         return self._S is None or self._S.empty()
 
+    def stats(self, reset=False):
+        """Subscription counters, or None after close().  See :py:meth:`p4p.client.thread.Subscription.stats`.
+        """
+        return None if self._S is None else self._S.stats(reset)
+
     @asyncio.coroutine
     def wait_closed(self):
         """Wait until subscription is closed.
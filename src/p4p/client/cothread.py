@@ -17,6 +17,7 @@ from ..wrapper import Value, Type
 from .._p4p import (logLevelAll, logLevelTrace, logLevelDebug,
                     logLevelInfo, logLevelWarn, logLevelError,
                     logLevelFatal, logLevelOff)
+from .._p4p import ReadyQueue
 
 __all__ = [
     'Context',
@@ -29,8 +30,46 @@ if sys.version_info >= (3, 0):
     unicode = str
 
 
+def _dispatch(ready):
+    # run until ReadyQueue.close()
+    while True:
+        cothread.poll_list([(ready.fileno(), cothread.POLLIN)])
+        batch = ready.drain()
+        if batch is None:
+            break
+        # handlers catch and log their own exceptions
+        for handler, args in batch:
+            handler(*args)
+
+
 class Context(raw.Context):
 
+    def __init__(self, *args, **kws):
+        super(Context, self).__init__(*args, **kws)
+
+        try:
+            ready = ReadyQueue()
+        except NotImplementedError:
+            # eg. on Windows.  Each callback passes through cothread.Callback()
+            pass
+        else:
+            # callbacks from PVA worker threads are queued, and dispatched in batches by a cothread.
+            # not a bound method, which would keep this Context alive
+            self._ready = ready
+            cothread.Spawn(_dispatch, ready)
+
+    def close(self):
+        ready, self._ready = self._ready, None
+        super(Context, self).close()
+        if ready is not None:
+            ready.close()  # _dispatch delivers any final events (eg. Cancelled), then exits
+
+    def _threadsafe(self, cb):
+        # wrap a callback to be run by a cothread
+        if self._ready is None:
+            cb = partial(cothread.Callback, cb)
+        return cb
+
     def get(self, name, request=None, timeout=5.0, throw=True):
         """Fetch current value of some number of PVs.
 
@@ -74,7 +113,7 @@ class Context(raw.Context):
             else:
                 done.Signal(value)
 
-        cb = partial(cothread.Callback, cb)
+        cb = self._threadsafe(cb)
 
         op = super(Context, self).get(name, cb, request=request)
 
@@ -155,7 +194,7 @@ class Context(raw.Context):
             else:
                 done.Signal(value)
 
-        cb = partial(cothread.Callback, cb)
+        cb = self._threadsafe(cb)
 
         op = super(Context, self).put(name, cb, builder=value, request=request, get=get)
 
@@ -203,7 +242,7 @@ class Context(raw.Context):
             else:
                 done.Signal(value)
 
-        cb = partial(cothread.Callback, cb)
+        cb = self._threadsafe(cb)
 
         op = super(Context, self).rpc(name, cb, value, request=request)
 
@@ -237,9 +276,10 @@ class Context(raw.Context):
         * A sub-class of Exception (Disconnected , RemoteError, or Cancelled)
         """
         R = Subscription(name, cb, notify_disconnect=notify_disconnect)
-        cb = partial(cothread.Callback, R._event)
+        cb = self._threadsafe(R._event)
 
-        R._S = super(Context, self).monitor(name, cb, request)
+        # Subscription drains the FIFO after each Data wakeup, so further wakeups are redundant
+        R._S = super(Context, self).monitor(name, cb, request, coalesce=True)
         return R
 
 
@@ -282,6 +322,11 @@ class Subscription(object):
         'Is data pending in event queue?'
         return self._S is None or self._S.empty()
 
+    def stats(self, reset=False):
+        """Subscription counters, or None after close().  See :py:meth:`p4p.client.thread.Subscription.stats`.
+        """
+        return None if self._S is None else self._S.stats(reset)
+
     def _event(self, value):
         if self._S is not None:
             self._Q.Signal(value)
@@ -58,20 +58,24 @@ class Finished(Disconnected):
 class RemoteError(RuntimeError):
     "Thrown with an error message which has been sent by a server to its remote client"
 
+def unwrapResult(code, msg, val, nt):
+    """Translate operation completion into a Value (or None), RemoteError, or Cancelled
+    """
+    if code == 0:
+        return RemoteError(msg)
+    elif code == 1:
+        return Cancelled()
+    elif val is not None:
+        return nt.unwrap(val)
+    return val
+
 def unwrapHandler(handler, nt):
     """Wrap get/rpc handler to unwrap Value
     """
     def dounwrap(code, msg, val):
         _log.debug("Handler (%s, %s, %s) -> %s", code, msg, LazyRepr(val), handler)
         try:
-            if code == 0:
-                handler(RemoteError(msg))
-            elif code == 1:
-                handler(Cancelled())
-            else:
-                if val is not None:
-                    val = nt.unwrap(val)
-                handler(val)
+            handler(unwrapResult(code, msg, val, nt))
         except:
             _log.exception("Exception in Operation handler")
     return dounwrap
@@ -154,6 +158,12 @@ class Subscription(_p4p.ClientMonitor):
         _log.debug("poll() -> %s", LazyRepr(val))
         return val
 
+    def pop_many(self, max=0, squash=False):
+        vals = super(Subscription, self).pop_many(max, squash)
+        vals = [self._nt.unwrap(val) for val in vals]
+        _log.debug("pop_many() -> %s", LazyRepr(vals))
+        return vals
+
     @property
     def done(self):
         return self.complete()
@@ -184,6 +194,8 @@ class Context(object):
         self._nt = buildNT(nt, unwrap)
 
         self._ctxt = None
+        # optional _p4p.ReadyQueue through which handlers are called.  see asyncio and cothread
+        self._ready = None
 
         # initialize channel cache
         self.disconnect()
@@ -261,7 +273,7 @@ class Context(object):
         """
         chan = self._channel(name)
         return _p4p.ClientOperation(chan, handler=unwrapHandler(handler, self._nt),
-                                    pvRequest=wrapRequest(request), get=True, put=False)
+                                    pvRequest=wrapRequest(request), get=True, put=False, queue=self._ready)
 
     def put(self, name, handler, builder=None, request=None, get=True):
         """Write a new value to a PV.
@@ -279,7 +291,22 @@ class Context(object):
         chan = self._channel(name)
         return _p4p.ClientOperation(chan, handler=unwrapHandler(handler, self._nt),
                                     builder=defaultBuilder(builder, self._nt),
-                                    pvRequest=wrapRequest(request), get=get, put=True)
+                                    pvRequest=wrapRequest(request), get=get, put=True, queue=self._ready)
+
+    def _multi(self, names, requests, builders=None, get=True, timeout=5.0):
+        """Issue Get, or Put if builders= is given, on several PVs and wait for all to complete.
+
+        :returns: A list of (code, msg, Value|None) as passed to an operation handler, or None
+                  for those not complete before the timeout.  see unwrapResult()
+
+        Operations are issued, and waited for, by native code without
+        re-entering the interpreter until all complete or timeout.
+        """
+        chans = [self._channel(N) for N in names]
+        if builders is not None:
+            builders = [defaultBuilder(B, self._nt) for B in builders]
+        return _p4p.ClientProvider.multi(chans, [wrapRequest(R) for R in requests],
+                                         builders=builders, get=get, timeout=timeout)
 
     def rpc(self, name, handler, value, request=None):
         """Perform RPC operation on PV
@@ -294,7 +321,7 @@ class Context(object):
         if value is None:
             value = Value(Type([]))
         return _p4p.ClientOperation(chan, handler=unwrapHandler(handler, self._nt),
-                                    value=value, pvRequest=wrapRequest(request), rpc=True)
+                                    value=value, pvRequest=wrapRequest(request), rpc=True, queue=self._ready)
 
     def monitor(self, name, handler, request=None, **kws):
         """Begin subscription to named PV
@@ -303,6 +330,9 @@ class Context(object):
         :param callable handler: Completion notification.  Called with None (FIFO not empty), RemoteError, Cancelled, or Disconnected
         :param request: A :py:class:`p4p.Value` or string to qualify this request, or None to use a default.
         :param bool notify_disconnect: Whether disconnect (and done) notifications are delivered to the callback (as None).
+        :param bool coalesce: If True, the handler is called with None only for the first update after
+                              pop() or pop_many() has found the FIFO empty.  The handler must then pop until empty.
+        :param int recycle: Number of released copies of updates to keep for re-use.  Default 4.
 
         :returns: A Subscription
         """
@@ -310,7 +340,7 @@ class Context(object):
         return Subscription(context=self,
                             nt=self._nt,
                             channel=chan, handler=monHandler(handler), pvRequest=wrapRequest(request),
-                            **kws)
+                            queue=self._ready, **kws)
 
 # static methods
 Context.providers = _p4p.ClientProvider.providers
@@ -0,0 +1,134 @@
+"""Recording of subscription updates to file, and reading back.
+
+Updates are written by native code, without entering the interpreter.
+"""
+
+from __future__ import print_function
+
+import logging
+_log = logging.getLogger(__name__)
+
+import os
+import sys
+import mmap
+
+import numpy
+
+from .. import _p4p
+from .raw import RemoteError, Cancelled, Disconnected, wrapRequest
+
+__all__ = (
+    'Recorder',
+    'read',
+    'columns',
+)
+
+
+class Recorder(_p4p.Recorder):
+
+    """Record updates of some PVs to file.
+
+    :param ctxt: A :py:class:`p4p.client.raw.Context` (or sub-class)
+    :param names: A list of PV name strings
+    :param str filename: File to which records are appended.  A partial record at the end of an existing file is discarded.
+    :param request: A :py:class:`p4p.Value` or string to qualify these subscriptions, or None to use a default.
+    :param int maxsize: When non-zero, rotate after 'filename' grows beyond this many bytes.
+    :param int maxfiles: Number of rotated files kept.  'filename.1' is the most recent.
+    :param int maxqueue: Limit, in bytes, of records waiting to be written.
+
+    Each file may be read on its own with :py:func:`read`.
+    Records are written by a dedicated thread, and buffered.  Call :py:meth:`flush` to ensure all are written.
+    If writing falls behind by more than 'maxqueue' bytes, then records are dropped and counted in :py:meth:`stats`.
+    The next update of a PV after a drop includes all fields.
+
+    >>> with Recorder(ctxt, ['pv:1', 'pv:2'], '/tmp/pvs.rec', maxsize=64<<20) as R:
+    ...     time.sleep(60.0)
+    ...     print(R.stats())
+    """
+
+    def __init__(self, ctxt, names, filename, request=None, maxsize=0, maxfiles=1, maxqueue=16 << 20):
+        _p4p.Recorder.__init__(self, [ctxt._channel(N) for N in names], filename,
+                               pvRequest=wrapRequest(request), maxsize=maxsize, maxfiles=maxfiles,
+                               maxqueue=maxqueue)
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, A, B, C):
+        self.close()
+
+
+def _event(code, msg):
+    if code == 1:
+        return RemoteError(msg)
+    elif code == 2:
+        return Cancelled()
+    else:
+        return Disconnected()
+
+
+def read(filename, nt=None):
+    """Read back a recording.
+
+    :param str filename: File written by :py:class:`Recorder`
+    :param nt: An object with an unwrap() method, eg. a :py:class:`p4p.nt.NTScalar`, or None to yield :py:class:`p4p.Value`.
+    :returns: A generator yielding tuples of (name, time, value).
+
+    'time' is the POSIX time of receipt.  'value' is a :py:class:`p4p.Value` with its changed
+    and overrun masks as originally received, or a RemoteError, Cancelled, or Disconnected.
+
+    A Value remains valid after the next iteration, but is less efficient if kept.
+    A partially written record at the end of the file is ignored.
+    """
+    with open(filename, 'rb') as F:
+        if os.fstat(F.fileno()).st_size == 0:
+            return
+        if sys.version_info >= (3, 0):
+            M = mmap.mmap(F.fileno(), 0, access=mmap.ACCESS_READ)
+        else:
+            M = F.read()
+
+        R = _p4p.RecordReader(M)
+        try:
+            while True:
+                rec = R.read()
+                if rec is None:
+                    break
+                name, T, code, msg, V = rec
+                if V is None:
+                    V = _event(code, msg)
+                elif nt is not None:
+                    V = nt.unwrap(V)
+                yield name, T, V
+        finally:
+            R.close()  # release before mmap.close()
+            if sys.version_info >= (3, 0):
+                M.close()
+
+
+def columns(filename, name, fields=('value',)):
+    """Read back updates of one PV as columns.
+
+    :param str filename: File written by :py:class:`Recorder`
+    :param str name: PV name
+    :param fields: Sequence of field names.
+    :returns: A tuple of (time, {'field':column}).  'time' is a numpy array of receipt times.
+              A column is a numpy array, or a list when elements are arrays of unequal length.
+
+    Events (eg. disconnect) are omitted.
+    """
+    T, cols = [], [[] for F in fields]
+    for N, t, V in read(filename):
+        if N != name or isinstance(V, Exception):
+            continue
+        T.append(t)
+        for F, C in zip(fields, cols):
+            C.append(V[F])
+
+    ret = {}
+    for F, C in zip(fields, cols):
+        try:
+            ret[F] = numpy.asarray(C)
+        except ValueError:
+            ret[F] = C
+    return numpy.asarray(T, dtype='f8'), ret
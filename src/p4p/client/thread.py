@@ -53,9 +53,10 @@ class Subscription(object):
     Returned by `Context.monitor`.
     """
 
-    def __init__(self, ctxt, name, cb, notify_disconnect=False, queue=None):
+    def __init__(self, ctxt, name, cb, notify_disconnect=False, queue=None, squash=False):
         self.name, self._S, self._cb = name, None, cb
         self._notify_disconnect = notify_disconnect
+        self._squash = squash
         self._Q = queue or ctxt._Q or _defaultWorkQueue()
         self._evt = threading.Event()
         if notify_disconnect:
@@ -88,6 +89,23 @@ class Subscription(object):
         'Is data pending in event queue?'
         return self._S is None or self._S.empty()
 
+    def stats(self, reset=False):
+        """Subscription counters, or None after close().
+
+        :param bool reset: Zero counters after reading.
+        :returns: A dict of counters.
+
+        * 'received' updates popped from the subscription FIFO.
+        * 'delivered' updates passed to the callback.  Less than 'received' when squashed.
+        * 'overruns' updates which replaced values not yet delivered.  see `p4p.Value.overrunSet`.
+        * 'squashed' updates merged into a later update before delivery.
+        * 'highwater' the largest number of updates popped without finding the FIFO empty.
+          Compare with the queueSize pvRequest option.
+        * 'copies' of delivered values which were still referenced when a later update was popped.
+        * 'recycled' copies made into the storage of earlier copies since released.
+        """
+        return None if self._S is None else self._S.stats(reset)
+
     def _event(self, E):
         try:
             assert self._S is not None, self._S
@@ -97,6 +115,9 @@ class Subscription(object):
             self._Q.push(partial(self._handle, E))
         except:
             _log.exception("Lost Subscription update: %s", LazyRepr(E))
+            if E is None and self._S is not None:
+                # FIFO will not be drained, so wakeups must not stay coalesced
+                self._S.rearm()
 
     def _handle(self, E):
         try:
@@ -117,13 +138,15 @@ class Subscription(object):
             elif S is None:  # already close()'d
                 return
 
-            for n in range(4):
-                E = S.pop()
-                if E is None:
-                    break
+            if self._squash:
+                # drain FIFO, keeping only the most recent
+                Es = S.pop_many(0, True)
+            else:
+                Es = S.pop_many(4)
+            for E in Es:
                 self._cb(E)
 
-            if E is not None:
+            if not self._squash and len(Es) == 4:
                 # removed 4 elements without emptying queue
                 # re-schedule to mux with others
                 self._Q.push(partial(self._handle, True))
@@ -248,41 +271,11 @@ class Context(raw.Context):
 
         assert len(name) == len(request), (name, request)
 
-        # use Queue instead of Event to allow KeyboardInterrupt
-        done = Queue()
-        result = [TimeoutError()] * len(name)
-        ops = [None] * len(name)
-
-        raw_get = super(Context, self).get
-
-        try:
-            for i, (N, req) in enumerate(izip(name, request)):
-                def cb(value, i=i):
-                    try:
-                        if not isinstance(value, Cancelled):
-                            done.put_nowait((value, i))
-                        _log.debug('get %s Q %s', N, LazyRepr(value))
-                    except:
-                        _log.exception("Error queuing get result %s", value)
-
-                _log.debug('get %s w/ %s', N, req)
-                ops[i] = raw_get(N, cb, request=req)
-
-            for _n in range(len(name)):
-                try:
-                    value, i = done.get(timeout=timeout)
-                except Empty:
-                    if throw:
-                        _log.debug('timeout %s after %s', name[i], timeout)
-                        raise TimeoutError()
-                    break
-                _log.debug('got %s %s', name[i], LazyRepr(value))
-                if throw and isinstance(value, Exception):
-                    raise value
-                result[i] = value
-
-        finally:
-            [op and op.close() for op in ops]
+        _log.debug('get %s w/ %s', name, request)
+        # all operations are waited for together without re-entering the interpreter.
+        # KeyboardInterrupt is still delivered.
+        result = self._results(self._multi(name, request, timeout=timeout), throw)
+        _log.debug('got %s %s', name, LazyRepr(result))
 
         if singlepv:
             return result[0]
@@ -340,47 +333,35 @@ class Context(raw.Context):
         assert len(name) == len(request), (name, request)
         assert len(name) == len(values), (name, values)
 
-        # use Queue instead of Event to allow KeyboardInterrupt
-        done = Queue()
-        result = [TimeoutError()] * len(name)
-        ops = [None] * len(name)
+        values = list(values)
+        for i, value in enumerate(values):
+            if isinstance(value, (bytes, unicode)) and value[:1] == '{':
+                try:
+                    values[i] = json.loads(value)
+                except ValueError:
+                    raise ValueError("Unable to interpret '%s' as json" % value)
 
-        raw_put = super(Context, self).put
+        # put never returns a Value
+        result = self._results(self._multi(name, request, builders=values, get=get, timeout=timeout), throw, value=False)
 
-        try:
-            for i, (n, value, req) in enumerate(izip(name, values, request)):
-                if isinstance(value, (bytes, unicode)) and value[:1] == '{':
-                    try:
-                        value = json.loads(value)
-                    except ValueError:
-                        raise ValueError("Unable to interpret '%s' as json" % value)
-
-                # completion callback
-                def cb(value, i=i):
-                    try:
-                        done.put_nowait((value, i))
-                    except:
-                        _log.exception("Error queuing put result %s", LazyRepr(value))
-
-                ops[i] = raw_put(n, cb, builder=value, request=req, get=get)
-
-            for _n in range(len(name)):
-                try:
-                    value, i = done.get(timeout=timeout)
-                except Empty:
-                    if throw:
-                        raise TimeoutError()
-                    break
-                if throw and isinstance(value, Exception):
-                    raise value
-                result[i] = value
-
-            if singlepv:
-                return result[0]
+        if singlepv:
+            return result[0]
+        else:
+            return result
+
+    def _results(self, results, throw, value=True):
+        """Translate results of raw._multi().  Incomplete operations become TimeoutError
+        """
+        ret = [None] * len(results)
+        for i, R in enumerate(results):
+            if R is None:
+                R = TimeoutError()
             else:
-                return result
-        finally:
-            [op and op.close() for op in ops]
+                R = raw.unwrapResult(R[0], R[1], R[2] if value else None, self._nt)
+            if throw and isinstance(R, Exception):
+                raise R
+            ret[i] = R
+        return ret
 
     def rpc(self, name, value, request=None, timeout=5.0, throw=True):
         """Perform a Remote Procedure Call (RPC) operation
@@ -421,7 +402,7 @@ class Context(raw.Context):
             op.close()
             raise
 
-    def monitor(self, name, cb, request=None, notify_disconnect=False, queue=None):
+    def monitor(self, name, cb, request=None, notify_disconnect=False, queue=None, squash=False):
         """Create a subscription.
 
         :param str name: PV name string
@@ -430,6 +411,8 @@ class Context(raw.Context):
         :param bool notify_disconnect: In additional to Values, the callback may also be call with instances of Exception.
                                        Specifically: Disconnected , RemoteError, or Cancelled
         :param WorkQueue queue: A work queue through which monitor callbacks are dispatched.
+        :param bool squash: If True, updates received since the last callback are combined.
+                            The callback is passed only the most recent, with all changes marked.
         :returns: a :py:class:`Subscription` instance
 
         The callable will be invoked with one argument which is either.
@@ -437,7 +420,8 @@ class Context(raw.Context):
         * A p4p.Value (Subject to :py:ref:`unwrap`)
         * A sub-class of Exception (Disconnected , RemoteError, or Cancelled)
         """
-        R = Subscription(self, name, cb, notify_disconnect=notify_disconnect, queue=queue)
+        R = Subscription(self, name, cb, notify_disconnect=notify_disconnect, queue=queue, squash=squash)
 
-        R._S = super(Context, self).monitor(name, R._event, request)
+        # Subscription drains the FIFO after each Data wakeup, so further wakeups are redundant
+        R._S = super(Context, self).monitor(name, R._event, request, coalesce=True)
         return R
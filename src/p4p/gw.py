@@ -131,6 +131,11 @@ statsType = Type([
     ('banHostSize', NTScalar.buildType('L')),
     ('banPVSize', NTScalar.buildType('L')),
     ('banHostPVSize', NTScalar.buildType('L')),
+    ('banHits', NTScalar.buildType('L')),
+    ('banEvictions', NTScalar.buildType('L')),
+    ('memCache', NTScalar.buildType('L')),
+    ('memQueue', NTScalar.buildType('L')),
+    ('memLimit', NTScalar.buildType('L')),
 ], id='epics:p2p/Stats:1.0')
 
 permissionsType = Type([
@@ -286,6 +291,16 @@ class GWStats(object):
         self.tbl_dsbyhosttx = addpv(dir='TX', suffix='ds:byhost:tx')
         self.tbl_dsbyhostrx = addpv(dir='RX', suffix='ds:byhost:rx')
 
+        # estimated memory usage by PV
+        self.tbl_memory = SharedPV(nt=TableBuilder([
+            ('s', 'name', 'PV'),
+            ('L', 'cache', 'Cache (B)'),
+            ('L', 'queue', 'Queue (B)'),
+            ('L', 'get', 'Get (B)'),
+            ('L', 'nsub', '# Subscriptions'),
+        ]), initial=[])
+        self._pvs['memory'] = self.tbl_memory
+
     def bindto(self, provider, prefix):
         'Add myself to a StaticProvider'
 
@@ -340,7 +355,9 @@ class GWStats(object):
             self.clientsPV.post([row[0] for row in C.execute('SELECT DISTINCT peer FROM us')])
 
         statsSum = {'ccacheSize.value':0, 'mcacheSize.value':0, 'gcacheSize.value':0,
-                    'banHostSize.value':0, 'banPVSize.value':0, 'banHostPVSize.value':0}
+                    'banHostSize.value':0, 'banPVSize.value':0, 'banHostPVSize.value':0,
+                    'banHits.value':0, 'banEvictions.value':0,
+                    'memCache.value':0, 'memQueue.value':0, 'memLimit.value':0}
         stats = [handler.provider.stats() for handler in self.handlers]
         for key in statsSum:
             for stat in stats:
@@ -349,6 +366,14 @@ class GWStats(object):
 
         self.cachePV.post(reduce(set.__or__, [handler.provider.cachePeek() for handler in self.handlers], set()))
 
+        mem = {}
+        for handler in self.handlers:
+            for usname, cache, queue, get, nsub in handler.provider.memoryReport():
+                prev = mem.get(usname, (0, 0, 0, 0))
+                mem[usname] = (prev[0]+cache, prev[1]+queue, prev[2]+get, prev[3]+nsub)
+        mem = sorted(mem.items(), key=lambda kv:sum(kv[1][:3]), reverse=True)[:10]
+        self.tbl_memory.post([(usname,)+usage for usname, usage in mem])
+
         T1 = time.time()
 
         self.statsTime.post(T1-T0)
@@ -376,6 +401,25 @@ class GWHandler(object):
             _log.debug("allowed: %s by %s -> %s", pvname, peer, ret)
             return ret
 
+    def testChannels(self, pvnames, peer):
+        _log.debug('%s Searching for %d names', peer, len(pvnames))
+        host = peer.split(':',1)[0]
+        ret = [self.provider.BanHostPV]*len(pvnames)
+        idxs, usnames = [], []
+
+        for i, pvname in enumerate(pvnames):
+            usname, _asg, _asl = self.pvlist.compute(pvname, host)
+            if not usname:
+                _log.debug("Not allowed: %s by %s", pvname, peer)
+            else:
+                idxs.append(i)
+                usnames.append(usname.encode('UTF-8'))
+
+        if usnames:
+            for i, R in zip(idxs, self.provider.testChannels(usnames)):
+                ret[i] = R
+        return ret
+
     def makeChannel(self, op):
         _log.debug("Create %s by %s", op.name, op.peer)
         peer = op.peer.split(':',1)[0]
@@ -642,6 +686,10 @@ class App(object):
 
                     if not args.test_config:
                         handler.provider = _gw.Provider(pname, client, handler) # implied installProvider()
+                        handler.provider.setMemoryLimit(int(jsrv.get('memlimit', 0)))
+                        handler.provider.setBanLimits(int(jsrv.get('banlimit', 100000)),
+                                                      float(jsrv.get('banttl', 0.0)))
+                        handler.provider.setSearchBatching(bool(jsrv.get('batchsearch', False)))
 
                     # prevent client from searching on ignored addresses
                     for addr in ignored_addresses:
@@ -184,9 +184,20 @@ class NTTable(object):
             {'A':42, 'B':'one'},
             {'A':43, 'B':'two'},
         ])
+
+        Alternately, a dict of column arrays or a numpy structured array
+        may be provided, which is converted in bulk.
+
+        >>> V = T.wrap({'A':numpy.asarray([42, 43]), 'B':['one', 'two']})
         """
         if isinstance(values, Value):
             return values
+        elif isinstance(values, dict) or getattr(getattr(values, 'dtype', None), 'names', None):
+            V = self.Value(self.type, {
+                'labels': self.labels,
+            })
+            V.fromcolumns(values, 'value')
+            return V
         cols = dict([(L, []) for L in self.labels])
         try:
             # unzip list of dict
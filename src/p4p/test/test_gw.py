@@ -174,11 +174,38 @@ class TestLowLevel(RefTestCase):
         val = self._ds_client.get('pv:ro', timeout=self.timeout)
         self.assertEqual(val, 43)
 
+    def test_get_batched(self):
+        self.gw.setSearchBatching(True)
+
+        R = self.gw.testChannels([b'pv:name', b'pv:name'])
+        self.assertEqual(len(R), 2)
+        self.assertIn(R[0], (self.gw.Claim, self.gw.Ignore))
+
+        val = self._ds_client.get('pv:ro', timeout=self.timeout)
+        self.assertEqual(val, 42)
+
+        with self.assertRaises(TimeoutError):
+            self._ds_client.get('invalid', timeout=0.1)
+        self.assertEqual(self.gw.stats()['banPVSize.value'], 1)
+
     def test_ban(self):
         with self.assertRaises(TimeoutError):
             self._ds_client.put('invalid', 40, timeout=0.1)
         # TODO: test cache
 
+    def test_ban_limit(self):
+        self.gw.setBanLimits(2, 0.0)
+        self.gw.forceBan(usname=b'forced')
+
+        for name in ('invalid1', 'invalid2', 'invalid3'):
+            with self.assertRaises(TimeoutError):
+                self._ds_client.get(name, timeout=0.1)
+
+        stats = self.gw.stats()
+        # forced entry is not counted against the limit
+        self.assertEqual(stats['banPVSize.value'], 3)
+        self.assertGreaterEqual(stats['banEvictions.value'], 1)
+
     def test_put(self):
         with self.assertRaises(RemoteError):
             self._ds_client.put('pv:ro', 40, timeout=self.timeout)
@@ -207,6 +234,31 @@ class TestLowLevel(RefTestCase):
                 with self.assertRaises(Empty):
                     Q2.get(timeout=0.01)
 
+    def test_memory(self):
+        Q = Queue(maxsize=4)
+
+        with self._ds_client.monitor('pv:ro', Q.put):
+            self.assertEqual(42, Q.get(timeout=self.timeout))
+
+            report = self.gw.memoryReport()
+            self.assertEqual(len(report), 1)
+            usname, cache, queue, get, nsub = report[0]
+            self.assertEqual(usname, u'pv:name')
+            self.assertGreater(cache, 0)
+            self.assertEqual(get, 0)
+            self.assertEqual(nsub, 1)
+
+            self.assertEqual(self.gw.stats()['memCache.value'], cache)
+
+            # cached monitor value already exceeds limit, so refuse new upstream GET
+            self.gw.setMemoryLimit(1)
+            self.assertEqual(self.gw.stats()['memLimit.value'], 1)
+            with self.assertRaises(RemoteError):
+                self._ds_client.get('pv:ro', timeout=self.timeout)
+
+            self.gw.setMemoryLimit(0)
+            self.assertEqual(self._ds_client.get('pv:ro', timeout=self.timeout), 42)
+
 class TestApp(App):
     def __init__(self, args):
         super(TestApp, self).__init__(args)
@@ -115,6 +115,29 @@ class TestTable(RefTestCase):
         assert_aequal(V.value.a, [5, 6])
         self.assertEqual(V.value.b, ['one', 'two'])
 
+    def test_wrap_columns(self):
+        NT = nt.NTTable(columns=[
+            ('a', 'i'),
+            ('b', 's'),
+        ])
+        V = NT.wrap({
+            'a': numpy.asarray([5, 6]),
+            'b': ['one', 'two'],
+        })
+
+        assert_aequal(V.value.a, [5, 6])
+        self.assertEqual(V.value.b, ['one', 'two'])
+        self.assertEqual(V.labels, ['a', 'b'])
+
+        S = V.value.tocolumns(structured=True)
+        self.assertEqual(S.dtype.names, ('a', 'b'))
+        assert_aequal(S['a'], [5, 6])
+        self.assertEqual(list(S['b']), ['one', 'two'])
+
+        V2 = NT.wrap(S)
+        assert_aequal(V2.value.a, [5, 6])
+        self.assertEqual(V2.value.b, ['one', 'two'])
+
     def test_unwrap(self):
         T = nt.NTTable.buildType(columns=[
             ('a', 'ai'),
@@ -195,6 +218,30 @@ class TestEnum(RefTestCase):
 
         self.assertEqual(V.value.index, 1)
 
+    def testStoreMany(self):
+        # longer choice lists are indexed
+        choices = ['pos%d' % i for i in range(1000)]
+        choices.append('pos10') # duplicate, first match wins
+        V = Value(nt.NTEnum.buildType(), {
+            'value.choices': choices,
+        })
+
+        for i in (0, 10, 999, 42):
+            V.value = 'pos%d' % i
+            self.assertEqual(V.value.index, i)
+
+        V.value = '7' # not a choice, so parsed
+        self.assertEqual(V.value.index, 7)
+
+        self.assertRaises(ValueError, setattr, V, 'value', 'other')
+
+        # replacement invalidates
+        V.value.choices = list(reversed(choices))
+        V.value = 'pos999'
+        self.assertEqual(V.value.index, 1)
+        V.value = 'pos10'
+        self.assertEqual(V.value.index, 0)
+
     def testStoreBad(self):
         V = Value(nt.NTEnum.buildType(), {
             'value.choices': ['zero', 'one', 'two'],
@@ -90,6 +90,20 @@ class TestGPM(RefTestCase):
         gc.collect()
         self.assertIsNone(C())
 
+    def testGetManyPartial(self):
+        with Context('pva', conf=self.server.conf(), useenv=False) as ctxt:
+            # 'foo' not open, so only 'bar' completes
+            R = ctxt.get(['bar', 'foo'], timeout=0.5, throw=False)
+            self.assertEqual(R[0], 42.0)
+            self.assertIsInstance(R[1], TimeoutError)
+
+            self.assertRaises(TimeoutError, ctxt.get, ['bar', 'foo'], timeout=0.1)
+
+        C = weakref.ref(ctxt)
+        del ctxt
+        gc.collect()
+        self.assertIsNone(C())
+
     def testPutGet(self):
         with Context('pva', conf=self.server.conf(), useenv=False) as ctxt:
 
@@ -148,6 +162,317 @@ class TestGPM(RefTestCase):
         gc.collect()
         self.assertIsNone(C())
 
+    def testMonitorKeep(self):
+        # Values kept after later updates are copied, into recycled storage after the first round
+        with Context('pva', conf=self.server.conf(), useenv=False) as ctxt:
+
+            self.pv.open(1.0)
+
+            Q = Queue(maxsize=4)
+            sub = ctxt.monitor('foo', Q.put)
+
+            V = Q.get(timeout=self.timeout)
+            self.assertEqual(V, 1.0)
+
+            for rnd in range(2):
+                vals = []
+                for i in range(1, 5):
+                    ctxt.put('foo', i)
+                    vals.append(Q.get(timeout=self.timeout))
+
+                self.assertListEqual([V.raw.value for V in vals], [2.0, 4.0, 6.0, 8.0])
+                del vals
+
+            # storage of the first round of copies was re-used by the second
+            S = sub.stats()
+            self.assertGreater(S['copies'], 0)
+            self.assertGreater(S['recycled'], 0)
+
+            sub.close()
+
+        C = weakref.ref(ctxt)
+        del ctxt
+        del sub
+        del Q
+        gc.collect()
+        self.assertIsNone(C())
+
+    def testMonitorPopMany(self):
+        import time
+        from ..client import raw
+        with raw.Context('pva', conf=self.server.conf(), useenv=False) as ctxt:
+
+            self.pv.open(1.0)
+
+            evt = threading.Event()
+            sub = ctxt.monitor('foo', lambda E: evt.set())
+
+            def waitfor(val, S=sub, E=evt, **kws):
+                # pop until 'val' is seen, returning all batches
+                batches = []
+                while not batches or batches[-1][-1:] != [val]:
+                    batch = S.pop_many(**kws)
+                    if batch:
+                        batches.append(batch)
+                    else:
+                        self.assertTrue(E.wait(self.timeout))
+                        E.clear()
+                return batches
+
+            self.assertListEqual(waitfor(1.0), [[1.0]])
+
+            for i in range(2, 6):
+                self.pv.post(float(i))
+            vals = sum(waitfor(5.0, max=2), [])
+            self.assertListEqual(vals, [2.0, 3.0, 4.0, 5.0])
+
+            for i in range(6, 10):
+                self.pv.post(float(i))
+            batches = waitfor(9.0, squash=True)
+            for batch in batches:
+                self.assertEqual(len(batch), 1)
+            self.assertIn('value', batches[-1][0].raw.changedSet())
+
+            self.assertListEqual(sub.pop_many(), [])
+
+            S = sub.stats(reset=True)
+            self.assertEqual(S['received'], S['delivered'] + S['squashed'])
+            self.assertGreaterEqual(S['received'], 9)
+            self.assertGreaterEqual(S['highwater'], 1)
+
+            S = sub.stats()
+            self.assertEqual(S['received'], 0)
+
+            # overflow a short FIFO, which keeps only the latest value
+            evt2 = threading.Event()
+            sub2 = ctxt.monitor('foo', lambda E: evt2.set(), request='record[queueSize=1]')
+            waitfor(9.0, S=sub2, E=evt2)
+
+            for i in range(10, 20):
+                self.pv.post(float(i))
+            time.sleep(0.5) # let updates arrive without popping
+            vals = sum(waitfor(19.0, S=sub2, E=evt2), [])
+            self.assertLess(len(vals), 10)
+
+            over = set()
+            for V in vals:
+                over |= V.raw.overrunSet()
+            self.assertIn('value', over)
+            self.assertGreater(sub2.stats()['overruns'], 0)
+
+            sub2.close()
+            sub.close()
+
+        C = weakref.ref(ctxt)
+        del ctxt
+        del sub
+        del sub2
+        gc.collect()
+        self.assertIsNone(C())
+
+    def testRecord(self):
+        import os, shutil, tempfile, time
+        from ..client.recorder import Recorder, read, columns
+
+        tdir = tempfile.mkdtemp()
+        try:
+            fname = os.path.join(tdir, 'test.rec')
+            with Context('pva', conf=self.server.conf(), useenv=False) as ctxt:
+                self.pv.open(1.0)
+
+                def waitfor(R, n):
+                    deadline = time.time() + 5.0
+                    while R.stats()['updates'] < n:
+                        self.assertLess(time.time(), deadline)
+                        time.sleep(0.01)
+
+                with Recorder(ctxt, ['foo', 'bar'], fname) as R:
+                    waitfor(R, 2)
+                    for i in range(2, 6):
+                        self.pv.post(float(i))
+                    waitfor(R, 6)
+                    R.flush()
+
+                    # may be read while recording
+                    self.assertGreaterEqual(len(list(read(fname))), 6)
+
+                    S = R.stats()
+                    self.assertEqual(S['files'], 1)
+                    self.assertIsNone(S['error'])
+
+                T, cols = columns(fname, 'foo')
+                self.assertListEqual(list(cols['value']), [1.0, 2.0, 3.0, 4.0, 5.0])
+                self.assertEqual(len(T), 5)
+
+                recs = [(N, V.value) for N, _T, V in read(fname) if N == 'bar']
+                self.assertListEqual(recs, [('bar', 42.0)])
+
+                # a partial record left by a crash is discarded before appending
+                with open(fname, 'ab') as F:
+                    F.write(b'U\xff\x00')
+                with Recorder(ctxt, ['foo'], fname) as R:
+                    waitfor(R, 1)
+                    self.assertEqual(R.stats()['dropped'], 0)
+
+                T, cols = columns(fname, 'foo')
+                self.assertListEqual(list(cols['value']), [1.0, 2.0, 3.0, 4.0, 5.0, 5.0])
+
+                # rotate after each update
+                fname = os.path.join(tdir, 'rotate.rec')
+                with Recorder(ctxt, ['foo'], fname, maxsize=1, maxfiles=2) as R:
+                    waitfor(R, 1)
+                    for i in range(6, 9):
+                        self.pv.post(float(i))
+                    waitfor(R, 4)
+
+                # each file is self contained
+                self.assertListEqual([V.value for N, T, V in read(fname)], [8.0])
+                self.assertListEqual([V.value for N, T, V in read(fname + '.1')], [7.0])
+                self.assertListEqual([V.value for N, T, V in read(fname + '.2')], [6.0])
+                self.assertFalse(os.path.exists(fname + '.3'))
+
+            del R
+            gc.collect()
+        finally:
+            shutil.rmtree(tdir)
+
+    def testMonitorCoalesce(self):
+        import time
+        from ..client import raw
+        with raw.Context('pva', conf=self.server.conf(), useenv=False) as ctxt:
+
+            self.pv.open(1.0)
+
+            evt = threading.Event()
+            wakeups = []
+            def handler(E):
+                wakeups.append(E)
+                evt.set()
+            sub = ctxt.monitor('foo', handler, coalesce=True)
+
+            while None not in wakeups:
+                self.assertTrue(evt.wait(self.timeout))
+                evt.clear()
+
+            for i in range(2, 6):
+                self.pv.post(float(i))
+            time.sleep(0.1)
+
+            # no further wakeups until FIFO is drained
+            self.assertEqual(wakeups.count(None), 1)
+
+            def drain(last):
+                vals = []
+                while vals[-1:] != [last]:
+                    batch = sub.pop_many()
+                    if batch:
+                        vals.extend(batch)
+                    else:
+                        self.assertTrue(evt.wait(self.timeout))
+                        evt.clear()
+                return vals
+
+            self.assertListEqual(drain(5.0), [1.0, 2.0, 3.0, 4.0, 5.0])
+
+            # re-armed
+            evt.clear()
+            self.pv.post(6.0)
+            self.assertListEqual(drain(6.0), [6.0])
+
+            sub.close()
+
+        C = weakref.ref(ctxt)
+        del ctxt
+        del sub
+        gc.collect()
+        self.assertIsNone(C())
+
+    def testMonitorQueueFull(self):
+        import time
+        # a wakeup lost to a full work queue must not stall the subscription
+        Q = WorkQueue(maxsize=1)
+        Q.push(lambda: None)  # full, with no worker yet
+
+        with Context('pva', conf=self.server.conf(), useenv=False) as ctxt:
+            self.pv.open(1.0)
+
+            vals = Queue()
+            sub = ctxt.monitor('foo', vals.put, queue=Q)
+
+            # allow the wakeup for the first update to be dropped
+            time.sleep(0.5)
+
+            T = threading.Thread(target=Q.handle)
+            T.start()
+            try:
+                self.pv.post(2.0)
+
+                V = None
+                while V != 2.0:
+                    V = vals.get(timeout=self.timeout)
+
+                sub.close()
+            finally:
+                Q.interrupt()
+                T.join()
+
+        C = weakref.ref(ctxt)
+        del ctxt
+        del sub
+        gc.collect()
+        self.assertIsNone(C())
+
+    def testReadyQueue(self):
+        import select
+        from ..client import raw
+        from .._p4p import ReadyQueue
+        try:
+            Q = ReadyQueue()
+        except NotImplementedError:
+            raise unittest.SkipTest("ReadyQueue not supported")
+
+        with raw.Context('pva', conf=self.server.conf(), useenv=False) as ctxt:
+            ctxt._ready = Q
+
+            self.pv.open(1.0)
+
+            results = []
+            op = ctxt.get('foo', results.append)
+
+            # handlers are only called from drain()
+            while not results:
+                R, _W, _E = select.select([Q], [], [], self.timeout)
+                self.assertListEqual(R, [Q])
+                for handler, args in Q.drain():
+                    handler(*args)
+
+            self.assertListEqual(results, [1.0])
+            self.assertListEqual(Q.drain(), [])
+            op.close()
+
+            # close() with entries still queued
+            Q2 = ctxt._ready = ReadyQueue()
+            op = ctxt.get('foo', results.append)
+            R, _W, _E = select.select([Q2], [], [], self.timeout)
+            self.assertListEqual(R, [Q2])
+            Q2.close()
+            self.assertEqual(len(Q2.drain()), 1)
+            # still readable, so an event loop will call drain() again
+            R, _W, _E = select.select([Q2], [], [], self.timeout)
+            self.assertListEqual(R, [Q2])
+            self.assertIsNone(Q2.drain())
+            op.close()
+            ctxt._ready = Q
+
+        Q.close()
+        self.assertIsNone(Q.drain())
+
+        C = weakref.ref(ctxt)
+        del ctxt
+        del op
+        gc.collect()
+        self.assertIsNone(C())
+
 class TestRPC(RefTestCase):
     maxDiff = 1000
     timeout = 1.0
@@ -188,6 +188,24 @@ class TestRawType(RefTestCase):
         T = _Type([('a', 'I')], id="foo")
         self.assertEqual(T.getID(), "foo")
 
+    def testCache(self):
+        A = _Type([('a', 'I'), ('b', ('S', 'foo', [('c', 'd')]))], id='x')
+        B = _Type([('a', 'I'), ('b', ('S', 'foo', [('c', 'd')]))], id='x')
+        self.assertIs(A, B)
+
+        C = _Type([('a', 'I')], id='x')
+        self.assertIsNot(A, C)
+        self.assertNotEqual(A, C)
+
+        # equal, but built differently
+        E = _Type([('b', ('S', 'foo', [('c', 'd')]))], id='x', base=_Type([('a', 'I')]))
+        self.assertIsNot(A, E)
+        self.assertEqual(A, E)
+        self.assertEqual(hash(A), hash(E))
+        self.assertEqual(len(set([A, B, E])), 1)
+
+        self.assertEqual(A().type(), A)
+
     def testExtend(self):
         B = _Type([('a', 'I')])
         S = _Type([('b', 'I')], base=B)
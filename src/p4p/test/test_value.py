@@ -150,6 +150,49 @@ class TestRawValue(RefTestCase):
         self.assertRaises(KeyError, V.__setitem__, 'foo', 5)
         self.assertRaises(AttributeError, setattr, V, 'foo', 5)
 
+    def testNestedFieldAccess(self):
+        T = Type([
+            ('alarm', ('S', None, [
+                ('severity', 'i'),
+            ])),
+            ('sub', ('S', None, [
+                ('alarm', ('S', None, [
+                    ('severity', 'i'),
+                ])),
+            ])),
+        ])
+        V1, V2 = Value(T), Value(T)
+
+        # Values of the same type share a name index
+        V1['alarm.severity'] = 1
+        V2['sub.alarm.severity'] = 2
+        self.assertEqual(V1.alarm.severity, 1)
+        self.assertEqual(V1['alarm.severity'], 1)
+        self.assertEqual(V2.sub.alarm.severity, 2)
+        self.assertEqual(V2.sub['alarm.severity'], 2)
+        self.assertEqual(V2.get('sub.alarm.severity'), 2)
+        self.assertTrue(V2.has('sub.alarm'))
+        self.assertFalse(V2.has('sub.severity'))
+        self.assertTrue(V2.changed('sub.alarm.severity'))
+        self.assertFalse(V2.changed('alarm.severity'))
+
+        # offsets are relative to the sub-structure
+        S = V2.sub
+        S.alarm.severity = 3
+        self.assertEqual(V2.sub.alarm.severity, 3)
+        self.assertEqual(V2.alarm.severity, 0)
+
+        self.assertRaises(KeyError, V1.__getitem__, 'alarm.foo')
+        self.assertRaises(KeyError, V1.changed, 'alarm.foo')
+
+        # instance attributes shadow sub-fields of the same name
+        class MyValue(Value):
+            pass
+        V3 = MyValue(T)
+        V3.__dict__['alarm'] = 'x'
+        self.assertEqual(V3.alarm, 'x')
+        self.assertEqual(V3['alarm.severity'], 0)
+
     def testReserved(self):
         L = [
             ("name", "s"),
@@ -177,6 +220,55 @@ class TestRawValue(RefTestCase):
         ])
         self.assertRaises(KeyError, Value, T, {'invalid': 42})
 
+    def testDictAssign(self):
+        # assignment plans are cached by Type and set of keys
+        T = Type([
+            ('ival', 'i'),
+            ('dval', 'd'),
+            ('sval', 's'),
+            ('bval', '?'),
+            ('sub', ('S', None, [
+                ('x', 'i'),
+            ])),
+        ])
+
+        for i in range(3):
+            V = Value(T, {'ival': i, 'dval': 1.5, 'sval': 'hello', 'sub.x': 2*i})
+            self.assertEqual(V.ival, i)
+            self.assertEqual(V.dval, 1.5)
+            self.assertEqual(V.sval, 'hello')
+            self.assertEqual(V.sub.x, 2*i)
+            self.assertSetEqual(V.changedSet(), {'ival', 'dval', 'sval', 'sub.x'})
+
+        # same keys, different order
+        V = Value(T, OrderedDict([('dval', 2), ('ival', 3.0)]))
+        V = Value(T, OrderedDict([('ival', 3.0), ('dval', 2)]))
+        self.assertEqual(V.ival, 3)
+        self.assertEqual(V.dval, 2.0)
+        self.assertSetEqual(V.changedSet(), {'ival', 'dval'})
+
+        # keys which are equal, but not the same object
+        key = ''.join(['i', 'val'])
+        V = Value(T, {key: 4})
+        V = Value(T, {''.join(['i', 'val']): 5})
+        self.assertEqual(V.ival, 5)
+
+        # with same plan, values of types which need the general conversions
+        for val in (True, np.int32(6), '7', 2**64-1):
+            V = Value(T, {'ival': val, 'sval': 8, 'bval': 1})
+            self.assertEqual(V.sval, '8')
+            self.assertIs(V.bval, True)
+        self.assertEqual(Value(T, {'ival': np.int32(6)}).ival, 6)
+        self.assertEqual(Value(T, {'ival': '7'}).ival, 7)
+
+        V = Value(T, {b'ival': 9, 'sub': {'x': 10}})
+        self.assertEqual(V.ival, 9)
+        self.assertEqual(V.sub.x, 10)
+
+        # not cached on error
+        for i in range(2):
+            self.assertRaises(KeyError, Value, T, {'ival': 1, 'invalid': 42})
+
     def testArray(self):
         V = Value(Type([
             ('ival', 'ai'),
@@ -192,6 +284,372 @@ class TestRawValue(RefTestCase):
         assert_aequal(V.dval, np.asfarray([1.1, 2.2]))
         self.assertListEqual(V.sval, [u'a', u'b'])
 
+    def testStringArray(self):
+        V = Value(Type([
+            ('a', 'as'),
+            ('b', 'as'),
+        ]), {
+            'a': ['x', u'y', 'z'],
+        })
+
+        self.assertListEqual(V.a, [u'x', u'y', u'z'])
+
+        S = V.get('a', lazy=True)
+        self.assertEqual(len(S), 3)
+        self.assertEqual(S[1], u'y')
+        self.assertEqual(S[-1], u'z')
+        self.assertEqual(S[:2], [u'x', u'y'])
+        self.assertEqual(list(S), [u'x', u'y', u'z'])
+        self.assertEqual(S.tolist(), [u'x', u'y', u'z'])
+        self.assertEqual(S, [u'x', u'y', u'z'])
+        self.assertNotEqual(S, [u'x'])
+        self.assertTrue(u'y' in S)
+        self.assertRaises(IndexError, lambda: S[3])
+        self.assertEqual(repr(S), repr([u'x', u'y', u'z']))
+
+        self.assertEqual(V.todict()['a'], [u'x', u'y', u'z'])
+        self.assertIsInstance(V.todict()['a'], list)
+
+        A = np.asarray(S)
+        self.assertEqual(A.dtype, np.dtype(object))
+        self.assertEqual(A.tolist(), [u'x', u'y', u'z'])
+        self.assertEqual(np.asarray(S, dtype='U').tolist(), [u'x', u'y', u'z'])
+
+        V.b = S
+        self.assertListEqual(V.b, [u'x', u'y', u'z'])
+        self.assertTrue(V.changed('b'))
+
+    def testArrayZeroCopy(self):
+        def addr(A):
+            return A.__array_interface__['data'][0]
+
+        V = Value(Type([
+            ('ival', 'ai'),
+            ('dval', 'ad'),
+        ]))
+
+        # read-only array is shared
+        A = np.arange(10, dtype='f8')
+        A.setflags(write=False)
+        V.dval = A
+        assert_aequal(V.dval, A)
+        self.assertEqual(addr(V.dval), addr(A))
+
+        # writable array is copied
+        B = np.arange(10, dtype='f8')
+        V.dval = B
+        B[0] = 42
+        self.assertEqual(V.dval[0], 0)
+        self.assertNotEqual(addr(V.dval), addr(B))
+
+        # read-only view of a writable array is copied
+        C = B[:]
+        C.setflags(write=False)
+        V.dval = C
+        self.assertNotEqual(addr(V.dval), addr(C))
+
+        # element type mis-match is converted
+        V.ival = A
+        assert_aequal(V.ival, np.arange(10))
+
+        # a slice of a previously fetched array is shared
+        D = V.dval[2:5]
+        V.ival = np.arange(3, dtype='i4')
+        V2 = Value(V.type(), {'dval': D})
+        assert_aequal(V2.dval, [2, 3, 4])
+        self.assertEqual(addr(V2.dval), addr(D))
+
+        # array remains valid after other references are dropped
+        A = np.arange(4, dtype='f8')
+        A.setflags(write=False)
+        V.dval = A
+        del A
+        gc.collect()
+        assert_aequal(V.dval, [0, 1, 2, 3])
+
+    def testColumns(self):
+        V = Value(Type([
+            ('tbl', ('S', None, [
+                ('x', 'ai'),
+                ('y', 'ad'),
+                ('s', 'as'),
+            ])),
+            ('rows', ('aS', None, [
+                ('x', 'i'),
+                ('y', 'd'),
+                ('s', 's'),
+            ])),
+        ]))
+
+        V.fromcolumns({'x': [1, 2, 3], 'y': np.asfarray([1.5, 2.5, 3.5]), 's': ['a', 'b', 'c']}, 'tbl')
+        self.assertTrue(V.changed('tbl.x'))
+        assert_aequal(V.tbl.x, [1, 2, 3])
+        assert_aequal(V.tbl.y, [1.5, 2.5, 3.5])
+        self.assertEqual(V.tbl.s, ['a', 'b', 'c'])
+
+        C = V.tocolumns('tbl')
+        self.assertEqual(set(C), set(['x', 'y', 's']))
+        assert_aequal(C['x'], [1, 2, 3])
+
+        S = V.tocolumns('tbl', structured=True)
+        self.assertEqual(S.dtype.names, ('x', 'y', 's'))
+        self.assertEqual(S.dtype['x'], np.dtype('i4'))
+        assert_aequal(S['y'], [1.5, 2.5, 3.5])
+
+        # array of structures from structured array
+        V.fromcolumns(S, 'rows')
+        self.assertTrue(V.changed('rows'))
+        self.assertEqual(len(V.rows), 3)
+        self.assertEqual(V.rows[1].x, 2)
+        self.assertEqual(V.rows[1].y, 2.5)
+        self.assertEqual(V.rows[1].s, 'b')
+
+        R = V.tocolumns('rows')
+        assert_aequal(R['x'], [1, 2, 3])
+        assert_aequal(R['y'], [1.5, 2.5, 3.5])
+        self.assertEqual(R['s'], ['a', 'b', 'c'])
+
+        R = V.tocolumns('rows', structured=True)
+        assert_aequal(R['x'], [1, 2, 3])
+        self.assertEqual(list(R['s']), ['a', 'b', 'c'])
+
+        # omitted column defaults
+        V.fromcolumns({'x': [4, 5]}, 'rows')
+        self.assertEqual(V.rows[1].x, 5)
+        self.assertEqual(V.rows[1].y, 0.0)
+
+        self.assertRaises(KeyError, V.fromcolumns, {'invalid': [1]}, 'rows')
+        self.assertRaises(ValueError, V.fromcolumns, {'x': [1], 'y': [1, 2]}, 'rows')
+
+        V.fromcolumns({'x': [1]}, 'tbl')
+        self.assertRaises(ValueError, V.tocolumns, 'tbl', structured=True)
+
+    def testSerialize(self):
+        from .._p4p import serialize, deserialize
+        import pickle
+
+        T = Type([
+            ('a', 'i'),
+            ('b', 'ad'),
+            ('c', ('S', None, [
+                ('d', 's'),
+            ])),
+        ])
+        V = T({'a': 5, 'b': [1.5, 2.5]})
+        V.c.d = 'hello'
+        V.unmark()
+        V.mark('a')
+
+        V2 = deserialize(serialize(V))
+        self.assertIsInstance(V2, Value)
+        self.assertEqual(V2.a, 5)
+        assert_aequal(V2.b, [1.5, 2.5])
+        self.assertEqual(V2.c.d, 'hello')
+        self.assertEqual(V2.changedSet(), set(['a']))
+
+        # big endian must be decoded as such
+        V2 = deserialize(serialize(V, be=True), be=True)
+        self.assertEqual(V2.a, 5)
+
+        # only changed fields
+        D = serialize(V, delta=True)
+        self.assertLess(len(D), len(serialize(V)))
+        V2 = deserialize(D)
+        self.assertEqual(V2.a, 5)
+        self.assertEqual(len(V2.b), 0)
+        self.assertEqual(V2.c.d, '')
+        self.assertEqual(V2.changedSet(), set(['a']))
+
+        V2 = pickle.loads(pickle.dumps(V, protocol=2))
+        self.assertEqual(V2.a, 5)
+        self.assertEqual(V2.c.d, 'hello')
+        self.assertEqual(V2.changedSet(), set(['a']))
+
+        self.assertRaises(ValueError, deserialize, serialize(V) + b'x')
+
+        # a sub-structure is serialized as a top-level structure
+        T = Type([
+            ('a', 'i'),
+            ('sub', ('S', None, [
+                ('x', 'i'),
+                ('y', 'i'),
+            ])),
+        ])
+        V = T({'a': 1, 'sub': {'x': 2, 'y': 3}})
+        V.unmark()
+        V.sub.y = 4
+
+        for S in (deserialize(serialize(V.sub)), pickle.loads(pickle.dumps(V.sub, protocol=2))):
+            self.assertEqual(S.x, 2)
+            self.assertEqual(S.y, 4)
+            self.assertEqual(S.changedSet(), set(['y']))
+
+        S = deserialize(serialize(V.sub, delta=True))
+        self.assertEqual(S.x, 0)
+        self.assertEqual(S.y, 4)
+        self.assertEqual(S.changedSet(), set(['y']))
+
+        # a marked parent marks all
+        V.mark('sub')
+        S = deserialize(serialize(V.sub, delta=True))
+        self.assertEqual((S.x, S.y), (2, 4))
+        self.assertEqual(S.changedSet(), set(['x', 'y']))
+
+    def testDiff(self):
+        T = Type([
+            ('a', 'i'),
+            ('b', 'ad'),
+            ('s', 'as'),
+            ('c', ('S', None, [
+                ('d', 's'),
+                ('e', 'd'),
+            ])),
+        ])
+        A = T({'a': 1, 'b': [1.0, 2.0], 's': ['x'], 'c': {'d': 'hello', 'e': 1.5}})
+        B = T({'a': 1, 'b': [1.0, 3.0], 's': ['x'], 'c': {'d': 'hello', 'e': 2.5}})
+
+        D = A.diff(B)
+        self.assertEqual(D.changedSet(), set(['b', 'c.e']))
+        assert_aequal(D.b, [1.0, 3.0])
+        self.assertEqual(D.c.e, 2.5)
+
+        A.unmark()
+        self.assertTrue(A.assign_changed(B))
+        self.assertEqual(A.changedSet(), set(['b', 'c.e']))
+        assert_aequal(A.b, [1.0, 3.0])
+
+        A.unmark()
+        self.assertFalse(A.assign_changed(B))
+        self.assertEqual(A.changedSet(), set())
+
+        self.assertRaises(ValueError, A.diff, Value(Type([('a', 'i')])))
+
+    def testClone(self):
+        A = Value(Type([
+            ('a', 'i'),
+            ('c', ('S', None, [
+                ('d', 'i'),
+            ])),
+        ]), {'a': 1, 'c.d': 2})
+        C = A.c
+
+        B = Value(clone=A)
+        self.assertEqual(B.a, 1)
+        self.assertEqual(B.changedSet(), A.changedSet())
+
+        # storage is copied by the first modification of either
+        B.a = 3
+        self.assertEqual(A.a, 1)
+        self.assertEqual(B.a, 3)
+
+        B2 = Value(clone=B)
+        A.c.d = 4
+        C.d = 5
+        self.assertEqual(A.c.d, 5)
+        self.assertEqual(C.d, 5)
+        self.assertEqual(B.c.d, 2)
+        self.assertEqual(B2.c.d, 2)
+
+        B2.mark('a', False)
+        self.assertEqual(B2.changedSet(), set(['c.d']))
+        self.assertEqual(B.changedSet(), set(['a', 'c.d']))
+
+        # clone of sub-structure
+        D = Value(clone=A.c)
+        D.d = 6
+        self.assertEqual(A.c.d, 5)
+        self.assertEqual(D.d, 6)
+
+        # storage no longer shared once the clone is released
+        B3 = Value(clone=A)
+        del B3
+        A.a = 7
+        C.d = 8
+        self.assertEqual(A.a, 7)
+        self.assertEqual(A.c.d, 8)
+
+    def testJSON(self):
+        import json
+        T = Type([
+            ('a', 'i'),
+            ('b', 'ad'),
+            ('s', 's'),
+            ('e', ('S', 'enum_t', [
+                ('index', 'i'),
+                ('choices', 'as'),
+            ])),
+            ('v', 'v'),
+            ('u', ('U', None, [
+                ('x', 'i'),
+                ('y', 's'),
+            ])),
+            ('sa', ('aS', None, [
+                ('q', 'd'),
+            ])),
+        ])
+        V = T({
+            'a': -5,
+            'b': [1.5, float('nan')],
+            's': 'hello "world"\n',
+            'e': {'choices': ['zero', 'one']},
+            'v': 4.5,
+            'u': ('y', 'why'),
+            'sa': [{'q': 1.0}],
+        })
+
+        J = json.loads(V.tojson().decode())
+        self.assertEqual(J['a'], -5)
+        self.assertEqual(J['b'][0], 1.5)
+        self.assertNotEqual(J['b'][1], J['b'][1]) # NaN
+        self.assertEqual(J['s'], 'hello "world"\n')
+        self.assertEqual(J['e'], {'index': 0, 'choices': ['zero', 'one']})
+        self.assertEqual(J['v'], 4.5)
+        self.assertEqual(J['u'], {'y': 'why'})
+        self.assertEqual(J['sa'], [{'q': 1.0}])
+
+        self.assertIn(b'null', V.tojson(nan='null'))
+        self.assertRaises(ValueError, V.tojson, nan='error')
+
+        V.unmark()
+        V.a = 6
+        self.assertEqual(json.loads(V.tojson(changed_only=True).decode()), {'a': 6})
+
+        V2 = T()
+        V2.fromjson(V.tojson())
+        self.assertEqual(V2.a, 6)
+        assert_aequal(V2.b[:1], [1.5])
+        self.assertEqual(V2.s, 'hello "world"\n')
+        self.assertEqual(V2.e.choices, ['zero', 'one'])
+        self.assertEqual(V2.v, 4.5)
+        self.assertEqual(V2.u, 'why')
+        self.assertEqual(V2.sa[0].q, 1.0)
+        self.assertTrue(V2.changed('a'))
+
+        V2.unmark()
+        V2.fromjson(u'{"e": "one", "v": [1, 2]}')
+        self.assertEqual(V2.e.index, 1)
+        assert_aequal(V2.v, [1, 2])
+        self.assertEqual(V2.changedSet(), set(['e.index', 'v']))
+
+        self.assertRaises(ValueError, V2.fromjson, '{"invalid": 1}')
+        V2.fromjson('{"invalid": {"x": [1]}}', strict=False)
+        self.assertRaises(ValueError, V2.fromjson, '{"a": 1')
+
+        # surrogate pairs
+        V2.fromjson(u'{"s": "\\ud83d\\ude00"}')
+        self.assertEqual(V2.s, u'\U0001f600')
+        self.assertRaises(ValueError, V2.fromjson, u'{"s": "\\ud800\\u0041"}')
+        self.assertRaises(ValueError, V2.fromjson, u'{"s": "\\ud800"}')
+        self.assertRaises(ValueError, V2.fromjson, u'{"s": "\\udc00"}')
+        self.assertRaises(ValueError, V2.fromjson, '{"invalid": ' + '[' * 100000 + ']' * 100000 + '}', strict=False)
+
+        # shortest form which round trips
+        V3 = Type([('d', 'd'), ('f', 'f')])({'d': 4.2, 'f': 0.1})
+        self.assertEqual(V3.tojson(), b'{"d":4.2,"f":0.1}')
+        V3.fromjson('{"d":0.30000000000000004}')
+        self.assertEqual(V3.d, 0.30000000000000004)
+        self.assertEqual(V3.tojson(), b'{"d":0.30000000000000004,"f":0.1}')
+
     def testSubStruct(self):
         V = Value(Type([
             ('ival', 'i'),
@@ -238,6 +696,26 @@ class TestRawValue(RefTestCase):
             ('b', 2),
         ])
 
+        V.unmark()
+        V.str.b = 3
+        self.assertDictEqual(V.todict(changed_only=True), {
+            'str': {
+                'b': 3,
+            },
+        })
+        self.assertListEqual(V.tolist(changed_only=True), [
+            ('str', [
+                ('b', 3),
+            ]),
+        ])
+        V.mark('str')
+        self.assertDictEqual(V.todict('str', changed_only=True), {
+            'a': 1,
+            'b': 3,
+        })
+        V.unmark()
+        self.assertDictEqual(V.todict(changed_only=True), {})
+
         self.assertEqual(V.str.a, 1)
         self.assertEqual(V.str['a'], 1)
         self.assertEqual(V['str'].a, 1)
@@ -593,6 +1071,25 @@ class TestRawValue(RefTestCase):
         self.assertSetEqual(A.changedSet(expand=False, parents=True),  {'z', 'z.q'})
         self.assertSetEqual(A.changedSet(expand=True, parents=True),   {'z', 'z.q', 'z.q.m'})
 
+        # names relative to a sub-structure
+        self.assertSetEqual(A.z.changedSet(expand=True, parents=True), {'q', 'q.m'})
+
+        A.unmark()
+        A.mark('y')
+        A.mark('z.q')
+        A.mark('z.a')
+        self.assertListEqual(list(A.iterChanged()), ['y', 'z.a', 'z.q'])
+        self.assertListEqual(list(A.iterChanged(expand=True)), ['y', 'z.a', 'z.q.m'])
+        self.assertListEqual(list(A.z.iterChanged()), ['a', 'q'])
+
+        # names are found lazily, from the mask as when iteration began
+        I = A.iterChanged()
+        self.assertIs(iter(I), I)
+        self.assertEqual(next(I), 'y')
+        A.unmark()
+        self.assertListEqual(list(I), ['z.a', 'z.q'])
+        self.assertListEqual(list(A.iterChanged()), [])
+
     def testTopAssignment(self):
         A = Value(Type([
             ('x', 'i'),
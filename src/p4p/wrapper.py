@@ -3,6 +3,7 @@
 # These types are then pushed (by _magic) down into extension
 # code where they will be used as the types passed to callbacks.
 from ._p4p import TypeBase, ValueBase
+from ._p4p import serialize as _serialize, deserialize as _deserialize
 
 __all__ = (
     'Type',
@@ -56,6 +57,9 @@ class Type(TypeBase):
             ])),
         ])
 
+    Types compare equal, and hash the same, when they define the same structure.
+    A Type built with the same arguments as an existing Type may be that same object.
+
     Type specifier codes:
 
     ==== =======
@@ -102,6 +106,10 @@ class Type(TypeBase):
 TypeBase._magic(Type)
 
 
+def _unpickle_value(data):
+    return _deserialize(data)
+
+
 class Value(ValueBase):
     """Value(type[, initial])
 
@@ -205,6 +213,10 @@ class Value(ValueBase):
 
     __str__ = ValueBase.tostr
 
+    def __reduce__(self):
+        # pickle through the pvAccess serialization, including the changed mask
+        return (_unpickle_value, (_serialize(self),))
+
     def __repr__(self):
         parts = []
 
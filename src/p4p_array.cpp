@@ -1,7 +1,11 @@
 /* The P4PArray type exists only to act as the base object for a numpy array
+ *
+ * The P4PStringArray type is a read-only sequence view of a string array
  */
 #include <stddef.h>
 
+#include <vector>
+
 #include "p4p.h"
 
 #define NO_IMPORT_ARRAY
@@ -15,9 +19,192 @@ namespace pvd = epics::pvData;
 
 typedef PyClassWrapper<array_type > P4PArray;
 
+struct StringArray {
+    string_array_type arr;
+    // elements decoded so far
+    std::vector<PyRef> cache;
+
+    // borrowed reference to element i, which must be in range
+    PyObject *item(size_t i) {
+        if(cache.empty())
+            cache.resize(arr.size());
+        PyRef& ent = cache[i];
+        if(!ent)
+            ent.reset(PyUnicode_FromStringAndSize(arr[i].c_str(), arr[i].size()));
+        if(!ent)
+            throw std::runtime_error("XXX");
+        return ent.get();
+    }
+
+    PyObject *tolist() {
+        PyRef ret(PyList_New(arr.size()));
+        for(size_t i=0; i<arr.size(); i++) {
+            PyObject *ent = item(i);
+            Py_INCREF(ent);
+            PyList_SET_ITEM(ret.get(), i, ent);
+        }
+        return ret.release();
+    }
+};
+
+typedef PyClassWrapper<StringArray> P4PStringArray;
+
+#define TRY P4PStringArray::reference_type SELF = P4PStringArray::unwrap(self); try
+
+Py_ssize_t stringarray_len(PyObject *self)
+{
+    TRY {
+        return SELF.arr.size();
+    }CATCH()
+    return -1;
+}
+
+PyObject* stringarray_item(PyObject *self, Py_ssize_t i)
+{
+    TRY {
+        if(i<0 || size_t(i)>=SELF.arr.size())
+            return PyErr_Format(PyExc_IndexError, "index out of range");
+        PyObject *ret = SELF.item(i);
+        Py_INCREF(ret);
+        return ret;
+    }CATCH()
+    return NULL;
+}
+
+PyObject* stringarray_subscript(PyObject *self, PyObject *key)
+{
+    TRY {
+        Py_ssize_t N = SELF.arr.size();
+
+        if(PySlice_Check(key)) {
+            Py_ssize_t start, stop, step, len;
+#if PY_MAJOR_VERSION < 3
+            if(PySlice_GetIndicesEx((PySliceObject*)key, N, &start, &stop, &step, &len))
+#else
+            if(PySlice_GetIndicesEx(key, N, &start, &stop, &step, &len))
+#endif
+                return NULL;
+
+            PyRef ret(PyList_New(len));
+            for(Py_ssize_t i=0, j=start; i<len; i++, j+=step) {
+                PyObject *ent = SELF.item(j);
+                Py_INCREF(ent);
+                PyList_SET_ITEM(ret.get(), i, ent);
+            }
+            return ret.release();
+
+        } else {
+            Py_ssize_t i = PyNumber_AsSsize_t(key, PyExc_IndexError);
+            if(i==-1 && PyErr_Occurred())
+                return NULL;
+            if(i<0)
+                i += N;
+            return stringarray_item(self, i);
+        }
+    }CATCH()
+    return NULL;
+}
+
+PyObject* stringarray_richcompare(PyObject *self, PyObject *other, int op)
+{
+    TRY {
+        // compare as list
+        PyRef rhs;
+        if(PyObject_TypeCheck(other, &P4PStringArray::type))
+            rhs.reset(P4PStringArray::unwrap(other).tolist());
+        else if(PyList_Check(other))
+            rhs.reset(other, borrow());
+        else
+            Py_RETURN_NOTIMPLEMENTED;
+
+        PyRef lhs(SELF.tolist());
+        return PyObject_RichCompare(lhs.get(), rhs.get(), op);
+    }CATCH()
+    return NULL;
+}
+
+PyObject* stringarray_repr(PyObject *self)
+{
+    TRY {
+        PyRef L(SELF.tolist());
+        return PyObject_Repr(L.get());
+    }CATCH()
+    return NULL;
+}
+
+PyObject* stringarray_tolist(PyObject *self)
+{
+    TRY {
+        return SELF.tolist();
+    }CATCH()
+    return NULL;
+}
+
+PyObject* stringarray_array(PyObject *self, PyObject *args, PyObject *kws)
+{
+    static const char* names[] = {"dtype", "copy", NULL};
+    PyObject *dtype = Py_None, *copy = Py_None;
+    if(!PyArg_ParseTupleAndKeywords(args, kws, "|OO", (char**)names, &dtype, &copy))
+        return NULL;
+    TRY {
+        npy_intp dim = SELF.arr.size();
+        PyRef arr(PyArray_SimpleNew(1, &dim, NPY_OBJECT));
+
+        for(npy_intp i=0; i<dim; i++) {
+            if(PyArray_SETITEM((PyArrayObject*)arr.get(), (char*)PyArray_GETPTR1((PyArrayObject*)arr.get(), i), SELF.item(i)))
+                return NULL;
+        }
+
+        if(dtype==Py_None)
+            return arr.release();
+
+        // eg. numpy.asarray(S, dtype='U') or StringDType
+        return PyObject_CallMethod(arr.get(), "astype", "O", dtype);
+    }CATCH()
+    return NULL;
+}
+
+PyObject* stringarray_reduce(PyObject *self)
+{
+    TRY {
+        // pickle as list
+        PyRef L(SELF.tolist());
+        return Py_BuildValue("O(O)", (PyObject*)&PyList_Type, L.get());
+    }CATCH()
+    return NULL;
+}
+
+#undef TRY
+
+PySequenceMethods stringarray_sequence = {
+    stringarray_len,
+    0, // concat
+    0, // repeat
+    stringarray_item,
+};
+
+PyMappingMethods stringarray_mapping = {
+    stringarray_len,
+    stringarray_subscript,
+    0, // ass_subscript
+};
+
+PyMethodDef stringarray_methods[] = {
+    {"tolist", (PyCFunction)&stringarray_tolist, METH_NOARGS,
+     "tolist() -> [str]\n\n"
+     "Decode all elements into a list."},
+    {"__array__", (PyCFunction)&stringarray_array, METH_VARARGS|METH_KEYWORDS,
+     "__array__(dtype=None, copy=None) -> numpy.ndarray\n\n"
+     "Decode all elements into a numpy array of dtype=object, or of the given dtype."},
+    {"__reduce__", (PyCFunction)&stringarray_reduce, METH_NOARGS,
+     "Pickle as list"},
+    {NULL}
+};
+
 } // namespace
 
 PyClassWrapper_DEF(P4PArray, "Array")
+PyClassWrapper_DEF(P4PStringArray, "StringArray")
 
 PyTypeObject* P4PArray_type = &P4PArray::type;
 
@@ -36,6 +223,20 @@ const array_type& P4PArray_extract(PyObject* o)
     return P4PArray::unwrap(o);
 }
 
+PyTypeObject* P4PStringArray_type = &P4PStringArray::type;
+
+PyObject* P4PStringArray_make(const string_array_type& v)
+{
+    PyRef ret(P4PStringArray::type.tp_new(&P4PStringArray::type, NULL, NULL));
+    P4PStringArray::unwrap(ret.get()).arr = v;
+    return ret.release();
+}
+
+const string_array_type& P4PStringArray_extract(PyObject* o)
+{
+    return P4PStringArray::unwrap(o).arr;
+}
+
 void p4p_array_register(PyObject *mod)
 {
     P4PArray::type.tp_flags = Py_TPFLAGS_DEFAULT|Py_TPFLAGS_BASETYPE;
@@ -47,4 +248,17 @@ void p4p_array_register(PyObject *mod)
     P4PArray::type.tp_doc = "Holder for a shared_array<> being shared w/ numpy";
 
     P4PArray::finishType(mod, "Array");
+
+    P4PStringArray::buildType();
+    P4PStringArray::type.tp_as_sequence = &stringarray_sequence;
+    P4PStringArray::type.tp_as_mapping = &stringarray_mapping;
+    P4PStringArray::type.tp_richcompare = &stringarray_richcompare;
+    P4PStringArray::type.tp_hash = &PyObject_HashNotImplemented;
+    P4PStringArray::type.tp_repr = &stringarray_repr;
+    P4PStringArray::type.tp_methods = stringarray_methods;
+
+    P4PStringArray::type.tp_doc = "Read-only sequence of the str elements of a string array field.\n"
+                                  "Elements are decoded on first access.  Compares equal to a list with the same elements.";
+
+    P4PStringArray::finishType(mod, "StringArray");
 }
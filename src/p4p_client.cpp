@@ -1,5 +1,22 @@
 
 #include <sstream>
+#include <algorithm>
+
+#ifdef _WIN32
+#  define P4P_NO_READYQUEUE
+#else
+#  include <unistd.h>
+#  include <fcntl.h>
+#  include <errno.h>
+#  ifdef __linux__
+#    include <stdint.h>
+#    include <sys/eventfd.h>
+#  endif
+#endif
+
+#include <epicsAtomic.h>
+#include <epicsEvent.h>
+#include <epicsTime.h>
 
 #include <pv/configuration.h>
 #include <pv/logger.h>
@@ -13,6 +30,102 @@ namespace pva = epics::pvAccess;
 typedef PyClassWrapper<pvac::ClientProvider, true> PyClientProvider;
 typedef PyClassWrapper<pvac::ClientChannel, true> PyClientChannel;
 
+// Identifies the handler of a ClientMonitor or ClientOperation to a ReadyQueue.
+// Only accessed with the GIL held, and cleared before the owner releases 'cb'.
+struct ReadyHandle {
+    PyObject *cb; // borrowed from owner
+    explicit ReadyHandle(PyObject *cb) :cb(cb) {}
+};
+
+// Client events queued from pvAccess worker threads, to be dispatched
+// by a python event loop which waits for fileno() to become readable.
+struct ReadyQueue {
+    struct Entry {
+        std::tr1::weak_ptr<ReadyHandle> handle;
+        int event;
+        std::string message;
+        // operation completion, handler called with a value (or None)
+        bool withvalue;
+        pvd::PVStructure::const_shared_pointer value;
+        pvd::BitSet valid;
+
+        Entry() :event(0), withvalue(false) {}
+    };
+
+    epicsMutex lock;
+    // guarded by lock
+    std::vector<Entry> entries;
+    bool closed;
+    // read end, and write end (same for eventfd)
+    int rfd, wfd;
+
+    ReadyQueue() :closed(false), rfd(-1), wfd(-1) {}
+
+#ifndef P4P_NO_READYQUEUE
+    void open() {
+#  ifdef __linux__
+        rfd = wfd = eventfd(0, EFD_NONBLOCK|EFD_CLOEXEC);
+        if(rfd<0)
+            throw std::runtime_error(SB()<<"eventfd() error "<<errno);
+#  else
+        int fds[2];
+        if(pipe(fds))
+            throw std::runtime_error(SB()<<"pipe() error "<<errno);
+        rfd = fds[0];
+        wfd = fds[1];
+        for(unsigned i=0; i<2; i++) {
+            fcntl(fds[i], F_SETFL, fcntl(fds[i], F_GETFL) | O_NONBLOCK);
+            fcntl(fds[i], F_SETFD, FD_CLOEXEC);
+        }
+#  endif
+    }
+#endif
+    ~ReadyQueue() {
+#ifndef P4P_NO_READYQUEUE
+        if(wfd!=rfd && wfd>=0)
+            ::close(wfd);
+        if(rfd>=0)
+            ::close(rfd);
+#endif
+    }
+
+    // call with lock held
+    void signal() {
+#ifndef P4P_NO_READYQUEUE
+#  ifdef __linux__
+        uint64_t one = 1u;
+        ssize_t ret = ::write(wfd, &one, sizeof(one));
+#  else
+        char one = 1;
+        ssize_t ret = ::write(wfd, &one, sizeof(one));
+#  endif
+        (void)ret; // EAGAIN when already signaled
+#endif
+    }
+    // call with lock held
+    void unsignal() {
+#ifndef P4P_NO_READYQUEUE
+        char buf[64];
+        while(::read(rfd, buf, sizeof(buf))>0) {}
+#endif
+    }
+
+    // may be called from any thread, without the GIL
+    void push(const Entry& ent) {
+        Guard G(lock);
+        if(closed)
+            return;
+        // only the first wakes up the loop
+        if(entries.empty())
+            signal();
+        entries.push_back(ent);
+    }
+
+    EPICS_NOT_COPYABLE(ReadyQueue)
+};
+
+typedef PyClassWrapper<std::tr1::shared_ptr<ReadyQueue> > PyReadyQueue;
+
 struct ClientMonitor : public pvac::ClientChannel::MonitorCallback {
     static size_t num_instances;
 
@@ -21,11 +134,38 @@ struct ClientMonitor : public pvac::ClientChannel::MonitorCallback {
     pvac::Monitor monitor;
     PyRef cb;
 
-    ClientMonitor() {
+    // storage of the Value last returned by pop(), which pvAccess will re-use.
+    // guarded by pollLock
+    std::tr1::weak_ptr<P4PValueRoot> lent;
+    // recycled storage for copies of lent Values.  NULL to allocate each copy
+    std::tr1::shared_ptr<P4PStructurePool> pool;
+
+    // when set, only the first Data event after the FIFO is found empty is passed to 'cb'
+    bool coalesce;
+    // (atomic) 1 after a Data event has been passed to 'cb'
+    int pending;
+
+    // if set, events are queued for dispatch by a python event loop
+    std::tr1::shared_ptr<ReadyQueue> ready;
+    std::tr1::shared_ptr<ReadyHandle> handle;
+
+    // counters, see clientmonitor_stats().  guarded by pollLock
+    struct Stats {
+        size_t received,  // updates popped from the subscription FIFO
+               delivered, // Values returned to python
+               overruns,  // updates with an overrun
+               squashed,  // updates merged by pop_many(squash=True)
+               backlog,   // consecutive updates popped since the FIFO was last found empty
+               highwater; // maximum backlog
+        Stats() :received(0u), delivered(0u), overruns(0u), squashed(0u), backlog(0u), highwater(0u) {}
+    } stats;
+
+    ClientMonitor() :coalesce(false), pending(0) {
         REFTRACE_INCREMENT(num_instances);
     }
 
     virtual ~ClientMonitor() {
+        reclaim();
         {
             PyUnlock U;
             monitor.cancel(); // we should be the only reference, but ... paranoia
@@ -33,8 +173,67 @@ struct ClientMonitor : public pvac::ClientChannel::MonitorCallback {
         REFTRACE_DECREMENT(num_instances);
     }
 
+    // copy out the Value last returned by pop(), if it is still referenced.
+    // The copy is made into storage recycled from earlier copies, which have since been released.
+    // call with pollLock and GIL locked, before monitor.poll() or cancel()
+    void reclaim()
+    {
+        std::tr1::shared_ptr<P4PValueRoot> R(lent.lock());
+        if(R)
+            R->detach();
+        lent.reset();
+    }
+
+    // poll(), and re-arm Data wakeups if the FIFO is empty.
+    // call with pollLock locked
+    bool poll()
+    {
+        bool ok = monitor.poll();
+        if(!ok && coalesce) {
+            epics::atomic::set(pending, 0);
+            // an update may have been queued just before re-arming, without a wakeup
+            ok = monitor.poll();
+            if(ok)
+                epics::atomic::set(pending, 1);
+        }
+
+        if(ok) {
+            stats.received++;
+            if(!monitor.overrun.isEmpty())
+                stats.overruns++;
+            stats.highwater = std::max(stats.highwater, ++stats.backlog);
+        } else {
+            stats.backlog = 0u;
+        }
+        return ok;
+    }
+
+    // overrun mask of the current update.  NULL if none
+    pvd::BitSet::shared_pointer overrun() const
+    {
+        pvd::BitSet::shared_pointer ret;
+        if(!monitor.overrun.isEmpty())
+            ret.reset(new pvd::BitSet(monitor.overrun));
+        return ret;
+    }
+
     virtual void monitorEvent(const pvac::MonitorEvent& evt)
     {
+        if(coalesce && evt.event==pvac::MonitorEvent::Data
+                && epics::atomic::compareAndSwap(pending, 0, 1)!=0) {
+            // previous wakeup not yet consumed
+            return;
+        }
+
+        if(ready) {
+            ReadyQueue::Entry ent;
+            ent.handle = handle;
+            ent.event = evt.event;
+            ent.message = evt.message;
+            ready->push(ent);
+            return;
+        }
+
         PyLock L;
         TRACE(evt.event<<" "<<evt.message<<" -> "<<cb.get());
 
@@ -65,6 +264,10 @@ struct ClientOperation : public pvac::ClientChannel::PutCallback,
     PyRef builder;
     PyRef getval; // only for put
 
+    // if set, completion is queued for dispatch by a python event loop
+    std::tr1::shared_ptr<ReadyQueue> ready;
+    std::tr1::shared_ptr<ReadyHandle> handle;
+
     ClientOperation() {
         REFTRACE_INCREMENT(num_instances);
     }
@@ -76,22 +279,41 @@ struct ClientOperation : public pvac::ClientChannel::PutCallback,
         REFTRACE_DECREMENT(num_instances);
     }
 
-    void prepvalue(PyRef& pyvalue, const pvd::PVStructure::const_shared_pointer& value, const pvd::BitSet* mask)
+    static void prepvalue(PyRef& pyvalue, const pvd::PVStructure::const_shared_pointer& value, const pvd::BitSet* mask)
     {
         if(value) {
             assert(mask);
-            pvd::PVStructure::shared_pointer V(pvd::getPVDataCreate()->createPVStructure(value->getStructure()));
-            V->copyUnchecked(*value);
             pvd::BitSet::shared_pointer valid(new pvd::BitSet(*mask));
 
-            pyvalue.reset(P4PValue_wrap(P4PValue_type, V, valid));
+            // this one-shot operation won't change 'value' again.  copy only if modified by python
+            std::tr1::shared_ptr<P4PValueRoot> root(new P4PValueRoot(std::tr1::const_pointer_cast<pvd::PVStructure>(value), true));
+
+            pyvalue.reset(P4PValue_wrap_shared(P4PValue_type, root, valid));
         } else {
             pyvalue.reset(Py_None, borrow());
         }
     }
 
+    void queue(const pvac::Event& evt, const pvd::PVStructure::const_shared_pointer& value, const pvd::BitSet* mask)
+    {
+        ReadyQueue::Entry ent;
+        ent.handle = handle;
+        ent.event = evt.event;
+        ent.message = evt.message;
+        ent.withvalue = true;
+        ent.value = value;
+        if(value && mask)
+            ent.valid = *mask;
+        ready->push(ent);
+    }
+
     virtual void getDone(const pvac::GetEvent& evt)
     {
+        if(ready) {
+            queue(evt, evt.value, evt.valid.get());
+            return;
+        }
+
         PyLock L;
         TRACE(evt.event<<" '"<<evt.message<<"' "<<!!evt.value<<" -> "<<cb.get());
 
@@ -113,7 +335,14 @@ struct ClientOperation : public pvac::ClientChannel::PutCallback,
                           pvac::ClientChannel::PutCallback::Args& args)
     {
         PyLock L;
+        callBuilder(builder.get(), build, args);
+    }
 
+    // call with GIL locked
+    static void callBuilder(PyObject *builder,
+                            const pvd::StructureConstPtr& build,
+                            pvac::ClientChannel::PutCallback::Args& args)
+    {
         PyRef pyvalue;
         prepvalue(pyvalue, args.previous, &args.previousmask);
         TRACE(pyvalue.get());
@@ -132,7 +361,7 @@ struct ClientOperation : public pvac::ClientChannel::PutCallback,
         }
         // builder callback is expected to populate the valid mask
 
-        PyRef ret(PyObject_CallFunction(builder.get(), "O", pyvalue.get()), allownull());
+        PyRef ret(PyObject_CallFunction(builder, "O", pyvalue.get()), allownull());
 
         if(!ret) {
             TRACE("ERROR");
@@ -150,6 +379,11 @@ struct ClientOperation : public pvac::ClientChannel::PutCallback,
 
     virtual void putDone(const pvac::PutEvent& evt)
     {
+        if(ready) {
+            queue(evt, pvd::PVStructure::const_shared_pointer(), 0);
+            return;
+        }
+
         PyLock L;
         TRACE(evt.event<<" '"<<evt.message<<"' -> "<<cb.get());
 
@@ -166,12 +400,108 @@ struct ClientOperation : public pvac::ClientChannel::PutCallback,
 
 size_t ClientOperation::num_instances;
 
+// Several get or put operations issued, and waited for, together.
+// Results are kept until all complete.  see clientprovider_multi()
+struct MultiOp {
+    struct Slot : public pvac::ClientChannel::GetCallback,
+                  public pvac::ClientChannel::PutCallback
+    {
+        MultiOp *owner;
+        PyObject *builder; // borrowed.  put only
+        pvac::Operation op;
+
+        // guarded by owner->lock
+        bool complete;
+        int event;
+        std::string message;
+        pvd::PVStructure::const_shared_pointer value;
+        pvd::BitSet valid;
+
+        Slot() :owner(0), builder(0), complete(false), event(0) {}
+        virtual ~Slot() {}
+
+        virtual void getDone(const pvac::GetEvent& evt)
+        {
+            owner->done(*this, evt, evt.value, evt.valid.get());
+        }
+
+        virtual void putBuild(const pvd::StructureConstPtr& build,
+                              pvac::ClientChannel::PutCallback::Args& args)
+        {
+            PyLock L;
+            ClientOperation::callBuilder(builder, build, args);
+        }
+
+        virtual void putDone(const pvac::PutEvent& evt)
+        {
+            owner->done(*this, evt, pvd::PVStructure::const_shared_pointer(), 0);
+        }
+    };
+
+    epicsMutex lock;
+    epicsEvent wakeup;
+    // guarded by lock
+    size_t remaining;
+    bool closed; // after cancel(), further completions (eg. Cancel) are ignored
+    // not resized after operations begin
+    std::vector<Slot> slots;
+
+    explicit MultiOp(size_t n) :remaining(n), closed(false), slots(n) {
+        for(size_t i=0; i<n; i++)
+            slots[i].owner = this;
+    }
+
+    void done(Slot& slot, const pvac::Event& evt,
+              const pvd::PVStructure::const_shared_pointer& value,
+              const pvd::BitSet* mask)
+    {
+        Guard G(lock);
+        if(slot.complete || closed)
+            return;
+        slot.complete = true;
+        slot.event = evt.event;
+        slot.message = evt.message;
+        slot.value = value;
+        if(mask)
+            slot.valid = *mask;
+        if(--remaining==0)
+            wakeup.signal();
+    }
+
+    // call without GIL.  returns false on timeout
+    bool wait(double timeout)
+    {
+        Guard G(lock);
+        while(remaining) {
+            UnGuard U(G);
+            if(!wakeup.wait(timeout))
+                return false;
+        }
+        return true;
+    }
+
+    // call without GIL.  No callbacks after return.
+    // Must be called before destruction, which would otherwise cancel implicitly (maybe with GIL).
+    void cancel()
+    {
+        {
+            Guard G(lock);
+            closed = true;
+        }
+        for(size_t i=0; i<slots.size(); i++)
+            slots[i].op.cancel();
+    }
+
+    EPICS_NOT_COPYABLE(MultiOp)
+};
+
 typedef PyClassWrapper<ClientOperation> PyClientOperation;
 
 PyClassWrapper_DEF(PyClientProvider, "ClientProvider")
 PyClassWrapper_DEF(PyClientChannel, "ClientChannel")
 PyClassWrapper_DEF(PyClientMonitor, "ClientMonitor")
 PyClassWrapper_DEF(PyClientOperation, "ClientOperation")
+PyClassWrapper_DEF(PyReadyQueue, "ReadyQueue")
 
 namespace {
 
@@ -313,6 +643,118 @@ PyObject* clientprovider_makeRequest(PyObject *junk, PyObject *args)
     return NULL;
 }
 
+PyObject* clientprovider_multi(PyObject *junk, PyObject *args, PyObject *kws)
+{
+    try {
+        static const char* names[] = {"channels", "requests", "builders", "get", "timeout", NULL};
+        PyObject *pychans, *pyreqs = Py_None, *pybuilders = Py_None, *pyget = Py_True;
+        double timeout = 5.0;
+        if(!PyArg_ParseTupleAndKeywords(args, kws, "O|OOOd", (char**)names,
+                                        &pychans, &pyreqs, &pybuilders, &pyget, &timeout))
+            return NULL;
+
+        PyRef chans(PySequence_Fast(pychans, "channels must be a sequence"));
+        const size_t n = PySequence_Fast_GET_SIZE(chans.get());
+
+        PyRef reqs, builders;
+        if(pyreqs!=Py_None) {
+            reqs.reset(PySequence_Fast(pyreqs, "requests must be a sequence"));
+            if(size_t(PySequence_Fast_GET_SIZE(reqs.get()))!=n)
+                return PyErr_Format(PyExc_ValueError, "requests must have the same length as channels");
+        }
+        if(pybuilders!=Py_None) {
+            builders.reset(PySequence_Fast(pybuilders, "builders must be a sequence"));
+            if(size_t(PySequence_Fast_GET_SIZE(builders.get()))!=n)
+                return PyErr_Format(PyExc_ValueError, "builders must have the same length as channels");
+        }
+        const bool put = !!builders, getput = PyObject_IsTrue(pyget);
+
+        std::vector<pvac::ClientChannel> channels(n);
+        std::vector<pvd::PVStructure::const_shared_pointer> requests(n);
+        MultiOp M(n);
+
+        for(size_t i=0; i<n; i++) {
+            PyObject *chan = PySequence_Fast_GET_ITEM(chans.get(), i);
+            if(!PyObject_TypeCheck(chan, &PyClientChannel::type))
+                return PyErr_Format(PyExc_TypeError, "channels[%u] must be ClientChannel", unsigned(i));
+            channels[i] = PyClientChannel::unwrap(chan);
+
+            if(reqs) {
+                PyObject *req = PySequence_Fast_GET_ITEM(reqs.get(), i);
+                if(req!=Py_None)
+                    requests[i] = P4PValue_unwrap(req);
+            }
+            if(put) {
+                // borrowed.  'builders' is kept alive until all operations are cancel()'d
+                M.slots[i].builder = PySequence_Fast_GET_ITEM(builders.get(), i);
+                if(!PyCallable_Check(M.slots[i].builder))
+                    return PyErr_Format(PyExc_TypeError, "builders[%u] must be callable", unsigned(i));
+            }
+        }
+
+        bool interrupted = false;
+        {
+            PyUnlock U;
+            try {
+                for(size_t i=0; i<n; i++) {
+                    MultiOp::Slot& slot = M.slots[i];
+                    if(put)
+                        slot.op = channels[i].put(&slot, requests[i], getput);
+                    else
+                        slot.op = channels[i].get(&slot, requests[i]);
+                }
+            } catch(...) {
+                M.cancel();
+                throw;
+            }
+        }
+
+        // only one wait for all.  Wake up periodically to check for eg. KeyboardInterrupt
+        epicsTime deadline(epicsTime::getCurrent() + timeout);
+        while(true) {
+            double remaining = deadline - epicsTime::getCurrent();
+            bool complete;
+            {
+                PyUnlock U;
+                complete = M.wait(remaining<=0.0 ? 0.0 : std::min(remaining, 0.1));
+            }
+            if(complete || remaining<=0.0) {
+                break;
+            } else if(PyErr_CheckSignals()) {
+                interrupted = true;
+                break;
+            }
+        }
+
+        {
+            PyUnlock U;
+            M.cancel();
+        }
+        if(interrupted)
+            return NULL;
+
+        PyRef ret(PyList_New(n));
+
+        for(size_t i=0; i<n; i++) {
+            const MultiOp::Slot& slot = M.slots[i];
+            PyRef item;
+
+            if(!slot.complete) {
+                item.reset(Py_None, borrow());
+            } else {
+                PyRef pyvalue;
+                ClientOperation::prepvalue(pyvalue, slot.value, &slot.valid);
+                item.reset(Py_BuildValue("isO", slot.event, slot.message.c_str(), pyvalue.get()));
+            }
+
+            PyList_SET_ITEM(ret.get(), i, item.release());
+        }
+
+        return ret.release();
+    }CATCH()
+    return NULL;
+}
+
 static PyMethodDef clientprovider_methods[] = {
     {"close", (PyCFunction)&clientprovider_close, METH_NOARGS,
      "close()\n"
@@ -329,6 +771,11 @@ static PyMethodDef clientprovider_methods[] = {
      "Set PVA debug level"},
     {"makeRequest", (PyCFunction)&clientprovider_makeRequest, METH_VARARGS|METH_STATIC,
      "makeRequest(\"field(value)\")\n\nParse pvRequest string"},
+    {"multi", (PyCFunction)&clientprovider_multi, METH_VARARGS|METH_KEYWORDS|METH_STATIC,
+     "multi(channels, requests=None, builders=None, get=True, timeout=5.0) -> [(code, msg, Value|None) | None, ...]\n"
+     "Get, or Put when builders= is given, on all channels.  Returns when all complete, or after timeout.\n"
+     "Results are as passed to a ClientOperation handler, or None if not complete.\n\n"
+     "A staticmethod."},
     {NULL}
 };
 
@@ -393,10 +840,11 @@ static PyMethodDef clientchannel_methods[] = {
 static int clientmonitor_init(PyObject *self, PyObject *args, PyObject *kws)
 {
     TRY {
-        static const char* names[] = {"channel", "handler", "pvRequest", NULL};
-        PyObject *chan, *cb, *pvReq = Py_None;
-        if(!PyArg_ParseTupleAndKeywords(args, kws, "O!O|O", (char**)names,
-                                        &PyClientChannel::type, &chan, &cb, &pvReq))
+        static const char* names[] = {"channel", "handler", "pvRequest", "recycle", "coalesce", "queue", NULL};
+        PyObject *chan, *cb, *pvReq = Py_None, *coalesce = Py_False, *queue = Py_None;
+        unsigned recycle = 4u;
+        if(!PyArg_ParseTupleAndKeywords(args, kws, "O!O|OIOO", (char**)names,
+                                        &PyClientChannel::type, &chan, &cb, &pvReq, &recycle, &coalesce, &queue))
             return -1;
 
         pvd::PVStructure::const_shared_pointer pvRequest;
@@ -409,6 +857,13 @@ static int clientmonitor_init(PyObject *self, PyObject *args, PyObject *kws)
         pvac::ClientChannel& channel = PyClientChannel::unwrap(chan);
 
         SELF.cb.reset(cb, borrow());
+        if(recycle)
+            SELF.pool.reset(new P4PStructurePool(recycle));
+        SELF.coalesce = PyObject_IsTrue(coalesce);
+        if(queue!=Py_None) {
+            SELF.ready = PyReadyQueue::unwrap(queue);
+            SELF.handle.reset(new ReadyHandle(cb));
+        }
         {
             PyUnlock U;
             SELF.monitor = channel.monitor(&SELF, pvRequest);
@@ -427,6 +882,10 @@ static PyObject *clientmonitor_close(PyObject *self)
         {
             PyUnlock U;
             Guard G(SELF.pollLock);
+            {
+                PyLock L;
+                SELF.reclaim();
+            }
             SELF.monitor.cancel();
         }
         Py_RETURN_NONE;
@@ -437,7 +896,7 @@ static PyObject *clientmonitor_close(PyObject *self)
 static PyObject *clientmonitor_pop(PyObject *self)
 {
     TRY {
-        pvd::PVStructure::shared_pointer root;
+        std::tr1::shared_ptr<P4PValueRoot> root;
         pvd::BitSet::shared_pointer changed;
         {
             PyUnlock U;
@@ -446,17 +905,26 @@ static PyObject *clientmonitor_pop(PyObject *self)
             // use pollLock to avoid race
             Guard G(SELF.pollLock);
 
-            if(SELF.monitor.poll()) {
+            {
+                // poll() releases the previous element for re-use
+                PyLock L;
+                SELF.reclaim();
+            }
+
+            if(SELF.poll()) {
                 assert(SELF.monitor.root.get());
-                root = pvd::getPVDataCreate()->createPVStructure(SELF.monitor.root->getStructure());
-                root->copyUnchecked(*SELF.monitor.root);
+                // share until modified, or until the next poll()
+                root.reset(new P4PValueRoot(std::tr1::const_pointer_cast<pvd::PVStructure>(SELF.monitor.root), true, true));
+                root->pool = SELF.pool;
+                root->overrun = SELF.overrun();
+                SELF.lent = root;
                 changed.reset(new pvd::BitSet(SELF.monitor.changed));
-                // TODO: something with SELF.monitor.overrun
+                SELF.stats.delivered++;
             }
         }
         if(root) {
             TRACE("Value");
-            return P4PValue_wrap(P4PValue_type, root, changed);
+            return P4PValue_wrap_shared(P4PValue_type, root, changed);
         } else {
             TRACE("None");
             Py_RETURN_NONE;
@@ -465,6 +933,152 @@ static PyObject *clientmonitor_pop(PyObject *self)
     return 0;
 }
 
+static PyObject *clientmonitor_pop_many(PyObject *self, PyObject *args, PyObject *kws)
+{
+    TRY {
+        static const char* names[] = {"max", "squash", NULL};
+        Py_ssize_t nmax = 0;
+        PyObject *pysquash = Py_False;
+        if(!PyArg_ParseTupleAndKeywords(args, kws, "|nO", (char**)names, &nmax, &pysquash))
+            return NULL;
+
+        bool squash = PyObject_IsTrue(pysquash);
+        // don't spin forever if updates arrive as fast as they are popped
+        const bool capped = nmax<=0;
+        if(capped)
+            nmax = 1024;
+
+        bool more = false;
+        std::vector<std::tr1::shared_ptr<P4PValueRoot> > roots;
+        std::vector<pvd::BitSet::shared_pointer> changes;
+        {
+            PyUnlock U;
+            Guard G(SELF.pollLock);
+
+            {
+                // poll() releases the previous element for re-use
+                PyLock L;
+                SELF.reclaim();
+            }
+
+            Py_ssize_t n;
+            for(n=0; n<nmax; n++) {
+                if(!roots.empty()) {
+                    // poll() releases the previous element, which we may still return.
+                    // not yet seen by python, so no GIL needed.
+                    // When squashing, only the first copy is complete.  Later elements update it in place.
+                    roots.back()->detach();
+                }
+
+                if(!SELF.poll())
+                    break;
+                assert(SELF.monitor.root.get());
+
+                if(squash && !roots.empty()) {
+                    // elements are complete.  copy in changed fields, and keep the union of changes.
+                    // fields changed by more than one element are also overrun.
+                    P4PValueRoot& prev = *roots.back();
+                    pvd::BitSet over(*changes.back());
+                    over &= SELF.monitor.changed;
+                    if(!SELF.monitor.overrun.isEmpty())
+                        over |= SELF.monitor.overrun;
+                    if(prev.overrun)
+                        over |= *prev.overrun;
+                    if(!over.isEmpty())
+                        prev.overrun.reset(new pvd::BitSet(over));
+
+                    prev.root->copyUnchecked(*SELF.monitor.root, SELF.monitor.changed);
+                    *changes.back() |= SELF.monitor.changed;
+                    SELF.stats.squashed++;
+                } else {
+                    std::tr1::shared_ptr<P4PValueRoot> root(new P4PValueRoot(std::tr1::const_pointer_cast<pvd::PVStructure>(SELF.monitor.root), true, true));
+                    root->pool = SELF.pool;
+                    root->overrun = SELF.overrun();
+
+                    roots.push_back(root);
+                    changes.push_back(pvd::BitSet::shared_pointer(new pvd::BitSet(SELF.monitor.changed)));
+                }
+            }
+            more = n==nmax;
+
+            // only the last may still be lent
+            if(!roots.empty() && roots.back()->lent)
+                SELF.lent = roots.back();
+            SELF.stats.delivered += roots.size();
+        }
+
+        PyRef ret(PyList_New(roots.size()));
+
+        for(size_t i=0; i<roots.size(); i++) {
+            PyList_SET_ITEM(ret.get(), i, P4PValue_wrap_shared(P4PValue_type, roots[i], changes[i]));
+        }
+
+        if(more && capped && SELF.coalesce) {
+            // stopped without finding the FIFO empty, so the handler won't otherwise be woken again
+            epics::atomic::set(SELF.pending, 0);
+            pvac::MonitorEvent evt;
+            evt.event = pvac::MonitorEvent::Data;
+            SELF.monitorEvent(evt);
+        }
+
+        TRACE("Values "<<roots.size());
+        return ret.release();
+    }CATCH()
+    return 0;
+}
+
+static PyObject *clientmonitor_stats(PyObject *self, PyObject *args, PyObject *kws)
+{
+    TRY {
+        static const char* names[] = {"reset", NULL};
+        PyObject *pyreset = Py_False;
+        if(!PyArg_ParseTupleAndKeywords(args, kws, "|O", (char**)names, &pyreset))
+            return NULL;
+
+        bool reset = PyObject_IsTrue(pyreset);
+        ClientMonitor::Stats stats;
+        size_t copies = 0u, recycled = 0u;
+        {
+            PyUnlock U;
+            Guard G(SELF.pollLock);
+            stats = SELF.stats;
+            if(reset) {
+                // backlog describes the FIFO, not the counting interval
+                size_t backlog = SELF.stats.backlog;
+                SELF.stats = ClientMonitor::Stats();
+                SELF.stats.backlog = backlog;
+            }
+            if(SELF.pool) {
+                Guard P(SELF.pool->lock);
+                copies = SELF.pool->copies;
+                recycled = SELF.pool->recycled;
+                if(reset)
+                    SELF.pool->copies = SELF.pool->recycled = 0u;
+            }
+        }
+
+        return Py_BuildValue("{snsnsnsnsnsnsn}",
+                             "received", Py_ssize_t(stats.received),
+                             "delivered", Py_ssize_t(stats.delivered),
+                             "overruns", Py_ssize_t(stats.overruns),
+                             "squashed", Py_ssize_t(stats.squashed),
+                             "highwater", Py_ssize_t(stats.highwater),
+                             "copies", Py_ssize_t(copies),
+                             "recycled", Py_ssize_t(recycled));
+    }CATCH()
+    return 0;
+}
+
+static PyObject *clientmonitor_rearm(PyObject *self)
+{
+    TRY {
+        // the wakeup passed to 'cb' was lost.  Allow the next Data event through.
+        epics::atomic::set(SELF.pending, 0);
+        Py_RETURN_NONE;
+    }CATCH()
+    return 0;
+}
+
 static PyObject *clientmonitor_complete(PyObject *self)
 {
     TRY {
@@ -489,6 +1103,24 @@ static PyMethodDef clientmonitor_methods[] = {
     {"pop", (PyCFunction)&clientmonitor_pop, METH_NOARGS,
      "pop() -> Value | None\n"
      "Pop next element from subscription FIFO"},
+    {"pop_many", (PyCFunction)&clientmonitor_pop_many, METH_VARARGS|METH_KEYWORDS,
+     "pop_many(max=0, squash=False) -> [Value]\n"
+     "Pop up to 'max' elements (or up to 1024 when max<=0) from subscription FIFO.\n"
+     "An empty list when the FIFO is empty.  With coalesce=True, if elements remain\n"
+     "then the handler is called again.\n"
+     "With squash=True, return only the most recent, with the changes of all popped elements marked."},
+    {"stats", (PyCFunction)&clientmonitor_stats, METH_VARARGS|METH_KEYWORDS,
+     "stats(reset=False) -> {'received':0, 'delivered':0, 'overruns':0, 'squashed':0, 'highwater':0, 'copies':0, 'recycled':0}\n"
+     "Subscription counters.  'received' updates popped from the FIFO, 'delivered' as Values,\n"
+     "'overruns' updates which replaced earlier values (see Value.overrunSet()),\n"
+     "'squashed' updates merged by pop_many(squash=True), and 'highwater' the most updates\n"
+     "popped without finding the FIFO empty.  'copies' of Values kept after a later update,\n"
+     "and how many of those were 'recycled' into released storage.\n"
+     "With reset=True, counters are zeroed after reading."},
+    {"rearm", (PyCFunction)&clientmonitor_rearm, METH_NOARGS,
+     "rearm()\n"
+     "With coalesce=True, call if a Data wakeup could not be acted upon (eg. work queue full)\n"
+     "and the FIFO will not be drained.  The next Data event will be passed to the handler."},
     {"complete", (PyCFunction)&clientmonitor_complete, METH_NOARGS,
      "complete() -> bool\n"
      "Has this subscription seen its final update.  Call after poll()."},
@@ -509,6 +1141,8 @@ static int clientmonitor_traverse(PyObject *self, visitproc visit, void *arg)
 static int clientmonitor_clear(PyObject *self)
 {
     TRY {
+        if(SELF.handle)
+            SELF.handle->cb = 0;
         if(SELF.cb) {
             PyRef tmp;
             SELF.cb.swap(tmp);
@@ -525,13 +1159,13 @@ static int clientoperation_init(PyObject *self, PyObject *args, PyObject *kws)
 {
     TRY {
         static const char* names[] = {"channel", "handler",
-                                      "value", "builder", "pvRequest", "get", "put", "rpc", NULL};
+                                      "value", "builder", "pvRequest", "get", "put", "rpc", "queue", NULL};
         PyObject *chan, *cb;
         PyObject *pyvalue = Py_None, *builder = Py_None, *pvReq = Py_None,
-                 *doGet = Py_False, *doPut = Py_False, *doRPC = Py_False;
-        if(!PyArg_ParseTupleAndKeywords(args, kws, "O!O|OOOOOO", (char**)names,
+                 *doGet = Py_False, *doPut = Py_False, *doRPC = Py_False, *queue = Py_None;
+        if(!PyArg_ParseTupleAndKeywords(args, kws, "O!O|OOOOOOO", (char**)names,
                                         &PyClientChannel::type, &chan, &cb,
-                                        &pyvalue, &builder, &pvReq, &doGet, &doPut, &doRPC))
+                                        &pyvalue, &builder, &pvReq, &doGet, &doPut, &doRPC, &queue))
             return -1;
 
         pvd::PVStructure::const_shared_pointer pvRequest;
@@ -545,6 +1179,10 @@ static int clientoperation_init(PyObject *self, PyObject *args, PyObject *kws)
         SELF.cb.reset(cb, borrow());
         SELF.pvRequest = pvRequest;
         SELF.chan = channel;
+        if(queue!=Py_None) {
+            SELF.ready = PyReadyQueue::unwrap(queue);
+            SELF.handle.reset(new ReadyHandle(cb));
+        }
 
         bool get = PyObject_IsTrue(doGet),
              put = PyObject_IsTrue(doPut),
@@ -621,6 +1259,8 @@ static int clientoperation_traverse(PyObject *self, visitproc visit, void *arg)
 static int clientoperation_clear(PyObject *self)
 {
     TRY {
+        if(SELF.handle)
+            SELF.handle->cb = 0;
         if(SELF.cb) {
             PyRef tmp;
             SELF.cb.swap(tmp);
@@ -638,6 +1278,114 @@ static int clientoperation_clear(PyObject *self)
     return -1;
 }
 
+#undef TRY
+#define TRY PyReadyQueue::reference_type SELF = PyReadyQueue::unwrap(self); try
+
+static int readyqueue_init(PyObject *self, PyObject *args, PyObject *kws)
+{
+    TRY {
+        static const char* names[] = {NULL};
+        if(!PyArg_ParseTupleAndKeywords(args, kws, "", (char**)names))
+            return -1;
+
+#ifdef P4P_NO_READYQUEUE
+        PyErr_SetString(PyExc_NotImplementedError, "ReadyQueue not supported on this target");
+        return -1;
+#else
+        SELF.reset(new ReadyQueue);
+        SELF->open();
+        return 0;
+#endif
+    }CATCH()
+    return -1;
+}
+
+static PyObject *readyqueue_fileno(PyObject *self)
+{
+    TRY {
+        if(!SELF)
+            return PyErr_Format(PyExc_RuntimeError, "Not initialized");
+        return PyLong_FromLong(SELF->rfd);
+    }CATCH()
+    return 0;
+}
+
+static PyObject *readyqueue_drain(PyObject *self)
+{
+    TRY {
+        if(!SELF)
+            return PyErr_Format(PyExc_RuntimeError, "Not initialized");
+
+        std::vector<ReadyQueue::Entry> todo;
+        {
+            Guard G(SELF->lock);
+            if(SELF->closed && SELF->entries.empty())
+                Py_RETURN_NONE;
+            // once closed, stay signaled so that the next drain() returns None
+            if(!SELF->closed)
+                SELF->unsignal();
+            todo.swap(SELF->entries);
+        }
+
+        PyRef ret(PyList_New(0));
+
+        for(size_t i=0; i<todo.size(); i++) {
+            const ReadyQueue::Entry& ent = todo[i];
+
+            std::tr1::shared_ptr<ReadyHandle> handle(ent.handle.lock());
+            if(!handle || !handle->cb)
+                continue; // owner gone
+
+            PyRef cbargs;
+            if(ent.withvalue) {
+                PyRef pyvalue;
+                ClientOperation::prepvalue(pyvalue, ent.value, &ent.valid);
+                cbargs.reset(Py_BuildValue("isO", ent.event, ent.message.c_str(), pyvalue.get()));
+            } else {
+                cbargs.reset(Py_BuildValue("is", ent.event, ent.message.c_str()));
+            }
+
+            PyRef item(PyTuple_Pack(2, handle->cb, cbargs.get()));
+
+            if(PyList_Append(ret.get(), item.get()))
+                return NULL;
+        }
+
+        return ret.release();
+    }CATCH()
+    return 0;
+}
+
+static PyObject *readyqueue_close(PyObject *self)
+{
+    TRY {
+        if(SELF) {
+            Guard G(SELF->lock);
+            if(!SELF->closed) {
+                SELF->closed = true;
+                // wake up the loop to notice
+                SELF->signal();
+            }
+        }
+        Py_RETURN_NONE;
+    }CATCH()
+    return 0;
+}
+
+static PyMethodDef readyqueue_methods[] = {
+    {"fileno", (PyCFunction)&readyqueue_fileno, METH_NOARGS,
+     "fileno() -> int\n"
+     "File descriptor which becomes readable when events are queued"},
+    {"drain", (PyCFunction)&readyqueue_drain, METH_NOARGS,
+     "drain() -> [(handler, args), ...] | None\n"
+     "Remove all queued events.  Dispatch each with handler(*args).\n"
+     "None once close()'d and empty."},
+    {"close", (PyCFunction)&readyqueue_close, METH_NOARGS,
+     "close()\n"
+     "Discard any future events.  fileno() becomes readable."},
+    {NULL}
+};
+
 #undef TRY
 
 } //namespace
@@ -689,4 +1437,14 @@ void p4p_client_register(PyObject *mod)
     PyClientOperation::type.tp_methods = clientoperation_methods;
 
     PyClientOperation::finishType(mod, "ClientOperation");
+
+
+    PyReadyQueue::buildType();
+
+    PyReadyQueue::type.tp_flags = Py_TPFLAGS_DEFAULT|Py_TPFLAGS_BASETYPE;
+    PyReadyQueue::type.tp_init = &readyqueue_init;
+
+    PyReadyQueue::type.tp_methods = readyqueue_methods;
+
+    PyReadyQueue::finishType(mod, "ReadyQueue");
 }
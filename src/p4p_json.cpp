@@ -0,0 +1,806 @@
+/* Direct translation between PVStructure and JSON text.
+ *
+ * Used by Value.tojson() and Value.fromjson() to avoid creating
+ * intermediate python objects.
+ */
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <ctype.h>
+
+#include <limits>
+
+#include <epicsMath.h>
+
+#include "p4p.h"
+
+namespace {
+
+namespace pvd = epics::pvData;
+
+/******************************** encode ********************************/
+
+struct Encoder {
+    std::string& out;
+    P4PJSONNaN nanpolicy;
+    char scratch[32];
+
+    Encoder(std::string& out, P4PJSONNaN nanpolicy) :out(out), nanpolicy(nanpolicy) {}
+
+    void string(const std::string& S)
+    {
+        out += '"';
+        for(size_t i=0; i<S.size(); i++) {
+            char c = S[i];
+            switch(c) {
+            case '"': out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            case '\b': out += "\\b"; break;
+            case '\f': out += "\\f"; break;
+            default:
+                if((unsigned char)c < 0x20) {
+                    sprintf(scratch, "\\u%04x", (unsigned)c);
+                    out += scratch;
+                } else {
+                    out += c; // UTF-8 passed through
+                }
+            }
+        }
+        out += '"';
+    }
+
+    void real(double v, bool single)
+    {
+        if(isnan(v) || isinf(v)) {
+            switch(nanpolicy) {
+            case P4PJSONNaNLiteral:
+                out += isnan(v) ? "NaN" : v>0 ? "Infinity" : "-Infinity";
+                return;
+            case P4PJSONNaNNull:
+                out += "null";
+                return;
+            case P4PJSONNaNError:
+                throw std::invalid_argument("NaN or Infinity can not be encoded as JSON");
+            }
+        }
+        // shortest text which reads back as the same value.
+        // Unlike printf(), PyOS_double_to_string() does not use the decimal point of the C locale.
+        char *str;
+        if(!single) {
+            str = PyOS_double_to_string(v, 'r', 0, 0, NULL);
+        } else {
+            const float f = float(v);
+            for(int prec=6; ; prec++) {
+                str = PyOS_double_to_string(v, 'g', prec, 0, NULL);
+                if(!str || prec>=9 || float(PyOS_string_to_double(str, NULL, NULL))==f)
+                    break;
+                PyMem_Free(str);
+            }
+        }
+        if(!str)
+            throw std::runtime_error("XXX");
+        out += str;
+        PyMem_Free(str);
+    }
+
+    void value(pvd::int64 v) { sprintf(scratch, "%lld", (long long)v); out += scratch; }
+    void value(pvd::uint64 v) { sprintf(scratch, "%llu", (unsigned long long)v); out += scratch; }
+    void value(pvd::boolean v) { out += v ? "true" : "false"; }
+
+    void scalar(const pvd::PVScalar& fld)
+    {
+        switch(fld.getScalar()->getScalarType()) {
+        case pvd::pvBoolean: value(fld.getAs<pvd::boolean>()); break;
+        case pvd::pvByte:
+        case pvd::pvShort:
+        case pvd::pvInt:
+        case pvd::pvLong: value(fld.getAs<pvd::int64>()); break;
+        case pvd::pvUByte:
+        case pvd::pvUShort:
+        case pvd::pvUInt:
+        case pvd::pvULong: value(fld.getAs<pvd::uint64>()); break;
+        case pvd::pvFloat: real(fld.getAs<double>(), true); break;
+        case pvd::pvDouble: real(fld.getAs<double>(), false); break;
+        case pvd::pvString: string(fld.getAs<std::string>()); break;
+        }
+    }
+
+    template<typename T, typename AS>
+    void intarray(const pvd::PVScalarArray& fld)
+    {
+        typename pvd::PVValueArray<T>::const_svector arr(static_cast<const pvd::PVValueArray<T>&>(fld).view());
+        out += '[';
+        for(size_t i=0; i<arr.size(); i++) {
+            if(i) out += ',';
+            value(AS(arr[i]));
+        }
+        out += ']';
+    }
+
+    template<typename T>
+    void realarray(const pvd::PVScalarArray& fld)
+    {
+        typename pvd::PVValueArray<T>::const_svector arr(static_cast<const pvd::PVValueArray<T>&>(fld).view());
+        out.reserve(out.size() + arr.size()*20u);
+        out += '[';
+        for(size_t i=0; i<arr.size(); i++) {
+            if(i) out += ',';
+            real(arr[i], sizeof(T)==4);
+        }
+        out += ']';
+    }
+
+    void scalarArray(const pvd::PVScalarArray& fld)
+    {
+        switch(fld.getScalarArray()->getElementType()) {
+        case pvd::pvBoolean: intarray<pvd::boolean, pvd::boolean>(fld); break;
+        case pvd::pvByte:    intarray<pvd::int8, pvd::int64>(fld); break;
+        case pvd::pvShort:   intarray<pvd::int16, pvd::int64>(fld); break;
+        case pvd::pvInt:     intarray<pvd::int32, pvd::int64>(fld); break;
+        case pvd::pvLong:    intarray<pvd::int64, pvd::int64>(fld); break;
+        case pvd::pvUByte:   intarray<pvd::uint8, pvd::uint64>(fld); break;
+        case pvd::pvUShort:  intarray<pvd::uint16, pvd::uint64>(fld); break;
+        case pvd::pvUInt:    intarray<pvd::uint32, pvd::uint64>(fld); break;
+        case pvd::pvULong:   intarray<pvd::uint64, pvd::uint64>(fld); break;
+        case pvd::pvFloat:   realarray<float>(fld); break;
+        case pvd::pvDouble:  realarray<double>(fld); break;
+        case pvd::pvString: {
+            pvd::PVStringArray::const_svector arr(static_cast<const pvd::PVStringArray&>(fld).view());
+            out += '[';
+            for(size_t i=0; i<arr.size(); i++) {
+                if(i) out += ',';
+                string(arr[i]);
+            }
+            out += ']';
+        }
+            break;
+        }
+    }
+
+    // A variant union is encoded as its value.
+    // A discriminating union as {"selected": value}
+    void union_(const pvd::PVUnion& fld)
+    {
+        pvd::PVField::const_shared_pointer val(fld.get());
+        if(!val) {
+            out += "null";
+
+        } else if(fld.getUnion()->isVariant()) {
+            field(*val, 0, true);
+
+        } else {
+            out += '{';
+            string(fld.getSelectedFieldName());
+            out += ':';
+            field(*val, 0, true);
+            out += '}';
+        }
+    }
+
+    // when 'mask' is provided, only include changed fields.
+    // 'all' is set when an enclosing field is changed
+    void structure(const pvd::PVStructure& fld, const pvd::BitSet* mask, bool all)
+    {
+        const pvd::PVFieldPtrArray& flds(fld.getPVFields());
+        const pvd::StringArray& names(fld.getStructure()->getFieldNames());
+        bool first = true;
+
+        out += '{';
+        for(size_t i=0; i<flds.size(); i++) {
+            const pvd::PVField& sub = *flds[i];
+            bool suball = all || !mask || mask->get(sub.getFieldOffset());
+
+            if(!suball) {
+                // any changed sub-field?
+                if(sub.getField()->getType()!=pvd::structure)
+                    continue;
+                pvd::int32 next = mask->nextSetBit(sub.getFieldOffset());
+                if(next<0 || size_t(next)>=sub.getNextFieldOffset())
+                    continue;
+            }
+
+            if(!first) out += ',';
+            first = false;
+            string(names[i]);
+            out += ':';
+            field(sub, mask, suball);
+        }
+        out += '}';
+    }
+
+    void field(const pvd::PVField& fld, const pvd::BitSet* mask, bool all)
+    {
+        switch(fld.getField()->getType()) {
+        case pvd::scalar:
+            scalar(static_cast<const pvd::PVScalar&>(fld));
+            break;
+        case pvd::scalarArray:
+            scalarArray(static_cast<const pvd::PVScalarArray&>(fld));
+            break;
+        case pvd::structure:
+            structure(static_cast<const pvd::PVStructure&>(fld), mask, all);
+            break;
+        case pvd::union_:
+            union_(static_cast<const pvd::PVUnion&>(fld));
+            break;
+        case pvd::structureArray: {
+            pvd::PVStructureArray::const_svector arr(static_cast<const pvd::PVStructureArray&>(fld).view());
+            out += '[';
+            for(size_t i=0; i<arr.size(); i++) {
+                if(i) out += ',';
+                if(arr[i])
+                    structure(*arr[i], 0, true);
+                else
+                    out += "null";
+            }
+            out += ']';
+        }
+            break;
+        case pvd::unionArray: {
+            pvd::PVUnionArray::const_svector arr(static_cast<const pvd::PVUnionArray&>(fld).view());
+            out += '[';
+            for(size_t i=0; i<arr.size(); i++) {
+                if(i) out += ',';
+                if(arr[i])
+                    union_(*arr[i]);
+                else
+                    out += "null";
+            }
+            out += ']';
+        }
+            break;
+        }
+    }
+};
+
+/******************************** decode ********************************/
+
+struct Decoder {
+    const char *pos, *end;
+    pvd::BitSet *changed;
+    // current nesting of objects and arrays
+    unsigned depth;
+
+    Decoder(const char *buf, size_t len, pvd::BitSet *changed) :pos(buf), end(buf+len), changed(changed), depth(0u) {}
+
+    // bound recursion on untrusted input
+    struct Nest {
+        Decoder& D;
+        explicit Nest(Decoder& D) :D(D) {
+            if(++D.depth > 256u) {
+                D.depth--;
+                D.fail("nesting too deep");
+            }
+        }
+        ~Nest() { D.depth--; }
+    };
+
+    void fail(const std::string& msg) const
+    {
+        throw std::invalid_argument(SB()<<"JSON "<<msg<<" at '"<<std::string(pos, std::min(end-pos, ptrdiff_t(16)))<<"'");
+    }
+
+    void ws()
+    {
+        while(pos<end && (*pos==' ' || *pos=='\t' || *pos=='\n' || *pos=='\r'))
+            pos++;
+    }
+
+    char peek()
+    {
+        ws();
+        if(pos==end)
+            fail("unexpected end");
+        return *pos;
+    }
+
+    void expect(char c)
+    {
+        if(peek()!=c)
+            fail(SB()<<"expected '"<<c<<"'");
+        pos++;
+    }
+
+    // consume ',' or 'close'.  Returns true if 'close'
+    bool next(char close)
+    {
+        char c = peek();
+        pos++;
+        if(c==close)
+            return true;
+        else if(c!=',')
+            fail(SB()<<"expected ',' or '"<<close<<"'");
+        return false;
+    }
+
+    bool keyword(const char *word)
+    {
+        size_t len = strlen(word);
+        if(size_t(end-pos)>=len && memcmp(pos, word, len)==0) {
+            pos += len;
+            return true;
+        }
+        return false;
+    }
+
+    static void utf8(std::string& out, unsigned cp)
+    {
+        if(cp<0x80) {
+            out += char(cp);
+        } else if(cp<0x800) {
+            out += char(0xc0 | (cp>>6));
+            out += char(0x80 | (cp&0x3f));
+        } else if(cp<0x10000) {
+            out += char(0xe0 | (cp>>12));
+            out += char(0x80 | ((cp>>6)&0x3f));
+            out += char(0x80 | (cp&0x3f));
+        } else {
+            out += char(0xf0 | (cp>>18));
+            out += char(0x80 | ((cp>>12)&0x3f));
+            out += char(0x80 | ((cp>>6)&0x3f));
+            out += char(0x80 | (cp&0x3f));
+        }
+    }
+
+    unsigned hex4()
+    {
+        if(end-pos<4)
+            fail("truncated escape");
+        unsigned ret = 0;
+        for(unsigned i=0; i<4; i++, pos++) {
+            char c = *pos;
+            ret <<= 4;
+            if(c>='0' && c<='9') ret |= c-'0';
+            else if(c>='a' && c<='f') ret |= c-'a'+10;
+            else if(c>='A' && c<='F') ret |= c-'A'+10;
+            else fail("invalid escape");
+        }
+        return ret;
+    }
+
+    std::string string()
+    {
+        expect('"');
+        std::string ret;
+        while(true) {
+            const char *start = pos;
+            while(pos<end && *pos!='"' && *pos!='\\')
+                pos++;
+            ret.append(start, pos-start);
+            if(pos==end)
+                fail("unterminated string");
+            if(*pos++=='"')
+                break;
+            if(pos==end)
+                fail("unterminated string");
+            switch(*pos++) {
+            case '"': ret += '"'; break;
+            case '\\': ret += '\\'; break;
+            case '/': ret += '/'; break;
+            case 'b': ret += '\b'; break;
+            case 'f': ret += '\f'; break;
+            case 'n': ret += '\n'; break;
+            case 'r': ret += '\r'; break;
+            case 't': ret += '\t'; break;
+            case 'u': {
+                unsigned cp = hex4();
+                if(cp>=0xd800 && cp<0xdc00) {
+                    // high surrogate must be followed by a low surrogate
+                    if(!(end-pos>=6 && pos[0]=='\\' && pos[1]=='u'))
+                        fail("invalid surrogate");
+                    pos += 2;
+                    unsigned lo = hex4();
+                    if(lo<0xdc00 || lo>=0xe000)
+                        fail("invalid surrogate");
+                    cp = 0x10000 + ((cp-0xd800)<<10) + (lo-0xdc00);
+                } else if(cp>=0xdc00 && cp<0xe000) {
+                    fail("invalid surrogate");
+                }
+                utf8(ret, cp);
+            }
+                break;
+            default:
+                pos--;
+                fail("invalid escape");
+            }
+        }
+        return ret;
+    }
+
+    // a number, or NaN/Infinity literal, as text
+    std::string number()
+    {
+        ws();
+        const char *start = pos;
+        if(keyword("NaN") || keyword("Infinity") || keyword("-Infinity"))
+            return std::string(start, pos-start);
+        while(pos<end && (isdigit((unsigned char)*pos) || *pos=='-' || *pos=='+' || *pos=='.' || *pos=='e' || *pos=='E'))
+            pos++;
+        if(pos==start)
+            fail("expected number");
+        return std::string(start, pos-start);
+    }
+
+    static bool isreal(const std::string& num)
+    {
+        return num.find_first_of(".eEIN")!=std::string::npos;
+    }
+
+    // parse a (not special) floating point number.
+    // Unlike strtod(), PyOS_string_to_double() does not use the decimal point of the C locale.
+    double real(const std::string& num)
+    {
+        char *tail = 0;
+        double ret = PyOS_string_to_double(num.c_str(), &tail, NULL);
+        if(ret==-1.0 && PyErr_Occurred()) {
+            PyErr_Clear();
+            fail("invalid number");
+        }
+        if(*tail)
+            fail("invalid number");
+        return ret;
+    }
+
+    // Skip any value.  Used for unknown keys.
+    void skip()
+    {
+        Nest N(*this);
+        char c = peek();
+        if(c=='"') {
+            string();
+        } else if(c=='{') {
+            pos++;
+            if(peek()=='}') { pos++; return; }
+            do {
+                string();
+                expect(':');
+                skip();
+            } while(!next('}'));
+        } else if(c=='[') {
+            pos++;
+            if(peek()==']') { pos++; return; }
+            do {
+                skip();
+            } while(!next(']'));
+        } else if(keyword("true") || keyword("false") || keyword("null")) {
+        } else {
+            number();
+        }
+    }
+
+    void mark(const pvd::PVField& fld)
+    {
+        if(changed)
+            changed->set(fld.getFieldOffset());
+    }
+
+    // NaN and Infinity, or null (as NaN), are only allowed for floating point
+    double special(const std::string& num, bool allowed)
+    {
+        if(!allowed)
+            fail("NaN, Infinity, or null not allowed for integer");
+        if(num=="Infinity")
+            return std::numeric_limits<double>::infinity();
+        else if(num=="-Infinity")
+            return -std::numeric_limits<double>::infinity();
+        return std::numeric_limits<double>::quiet_NaN();
+    }
+
+    static bool isspecial(const std::string& num)
+    {
+        return num=="NaN" || num=="Infinity" || num=="-Infinity";
+    }
+
+    void scalar(pvd::PVScalar& fld)
+    {
+        pvd::ScalarType t = fld.getScalar()->getScalarType();
+        bool floating = t==pvd::pvFloat || t==pvd::pvDouble;
+
+        char c = peek();
+        if(c=='"') {
+            fld.putFrom(string());
+        } else if(keyword("true")) {
+            fld.putFrom<pvd::boolean>(1);
+        } else if(keyword("false")) {
+            fld.putFrom<pvd::boolean>(0);
+        } else if(keyword("null")) {
+            fld.putFrom<double>(special("NaN", floating));
+        } else {
+            std::string num(number());
+            if(isspecial(num))
+                fld.putFrom<double>(special(num, floating));
+            else if(floating)
+                fld.putFrom<double>(real(num));
+            else
+                fld.putFrom(num); // pvData parses to the field type
+        }
+        mark(fld);
+    }
+
+    template<typename T>
+    T element()
+    {
+        const bool floating = !std::numeric_limits<T>::is_integer;
+        if(keyword("true")) return T(1);
+        if(keyword("false")) return T(0);
+        if(keyword("null")) return T(special("NaN", floating));
+        std::string num(number());
+        if(isspecial(num))
+            return T(special(num, floating));
+        else if(floating)
+            return T(real(num));
+        return pvd::castUnsafe<T, std::string>(num);
+    }
+
+    template<typename T>
+    void array(pvd::PVScalarArray& fld)
+    {
+        pvd::shared_vector<T> arr;
+        expect('[');
+        if(peek()==']') {
+            pos++;
+        } else {
+            do {
+                ws();
+                arr.push_back(element<T>());
+            } while(!next(']'));
+        }
+        static_cast<pvd::PVValueArray<T>&>(fld).replace(pvd::freeze(arr));
+    }
+
+    void scalarArray(pvd::PVScalarArray& fld)
+    {
+        switch(fld.getScalarArray()->getElementType()) {
+        case pvd::pvBoolean: array<pvd::boolean>(fld); break;
+        case pvd::pvByte:    array<pvd::int8>(fld); break;
+        case pvd::pvShort:   array<pvd::int16>(fld); break;
+        case pvd::pvInt:     array<pvd::int32>(fld); break;
+        case pvd::pvLong:    array<pvd::int64>(fld); break;
+        case pvd::pvUByte:   array<pvd::uint8>(fld); break;
+        case pvd::pvUShort:  array<pvd::uint16>(fld); break;
+        case pvd::pvUInt:    array<pvd::uint32>(fld); break;
+        case pvd::pvULong:   array<pvd::uint64>(fld); break;
+        case pvd::pvFloat:   array<float>(fld); break;
+        case pvd::pvDouble:  array<double>(fld); break;
+        case pvd::pvString: {
+            pvd::shared_vector<std::string> arr;
+            expect('[');
+            if(peek()==']') {
+                pos++;
+            } else {
+                do {
+                    arr.push_back(string());
+                } while(!next(']'));
+            }
+            static_cast<pvd::PVStringArray&>(fld).replace(pvd::freeze(arr));
+        }
+            break;
+        }
+        mark(fld);
+    }
+
+    // enum_t may be assigned by index or choice string
+    bool enumeration(pvd::PVStructure& fld)
+    {
+        char c = peek();
+        if(c=='{' || fld.getStructure()->getID()!="enum_t")
+            return false;
+
+        pvd::PVScalar::shared_pointer index(fld.getSubField<pvd::PVScalar>("index"));
+        pvd::PVStringArray::const_shared_pointer choices(fld.getSubField<pvd::PVStringArray>("choices"));
+        if(!index || !choices)
+            fail("assignment of non-complient enum_t");
+
+        if(c=='"') {
+            std::string str(string());
+            pvd::PVStringArray::const_svector C(choices->view());
+            size_t i;
+            for(i=0; i<C.size(); i++) {
+                if(C[i]==str)
+                    break;
+            }
+            if(i<C.size())
+                index->putFrom<pvd::int32>(i);
+            else
+                index->putFrom(str);
+            mark(*index);
+        } else {
+            scalar(*index);
+        }
+        return true;
+    }
+
+    void structure(pvd::PVStructure& fld, bool strict)
+    {
+        if(enumeration(fld))
+            return;
+
+        const pvd::StructureConstPtr& type(fld.getStructure());
+        const pvd::PVFieldPtrArray& flds(fld.getPVFields());
+
+        expect('{');
+        if(peek()=='}') {
+            pos++;
+            return;
+        }
+        do {
+            std::string key(string());
+            expect(':');
+            size_t idx = type->getFieldIndex(key);
+            if(idx==size_t(-1)) {
+                if(strict)
+                    throw std::invalid_argument(SB()<<"no sub-field "<<fld.getFullName()<<"."<<key);
+                skip();
+            } else {
+                field(*flds[idx], strict);
+            }
+        } while(!next('}'));
+    }
+
+    // guess a type for a variant union
+    pvd::FieldConstPtr guess()
+    {
+        pvd::FieldCreatePtr create(pvd::getFieldCreate());
+        char c = peek();
+        if(c=='"') {
+            return create->createScalar(pvd::pvString);
+        } else if(c=='t' || c=='f') {
+            return create->createScalar(pvd::pvBoolean);
+        } else if(c=='[') {
+            // guess from first element
+            const char *save = pos;
+            pos++;
+            pvd::ScalarType etype = pvd::pvDouble;
+            c = peek();
+            if(c=='"') {
+                etype = pvd::pvString;
+            } else if(c=='t' || c=='f') {
+                etype = pvd::pvBoolean;
+            } else if(c!=']' && c!='n') {
+                etype = isreal(number()) ? pvd::pvDouble : pvd::pvLong;
+            }
+            pos = save;
+            return create->createScalarArray(etype);
+        } else if(c=='{') {
+            fail("can't assign object to variant union");
+        } else {
+            const char *save = pos;
+            bool real = isreal(number());
+            pos = save;
+            return create->createScalar(real ? pvd::pvDouble : pvd::pvLong);
+        }
+        return pvd::FieldConstPtr(); // not reached
+    }
+
+    void union_(pvd::PVUnion& fld, bool strict)
+    {
+        if(peek()=='n' && keyword("null")) {
+            fld.select(pvd::PVUnion::UNDEFINED_INDEX);
+            return;
+        }
+
+        pvd::BitSet *save = changed;
+        changed = 0; // no tracking inside unions
+        try {
+            if(fld.getUnion()->isVariant()) {
+                pvd::PVFieldPtr val(pvd::getPVDataCreate()->createPVField(guess()));
+                field(*val, strict);
+                fld.set(val);
+
+            } else {
+                expect('{');
+                std::string key(string());
+                expect(':');
+                pvd::PVFieldPtr val;
+                try {
+                    val = fld.select(key);
+                } catch(std::invalid_argument&) {
+                    throw std::invalid_argument(SB()<<"no union member "<<fld.getFullName()<<"."<<key);
+                }
+                field(*val, strict);
+                expect('}');
+            }
+        } catch(...) {
+            changed = save;
+            throw;
+        }
+        changed = save;
+    }
+
+    void field(pvd::PVField& fld, bool strict)
+    {
+        Nest N(*this);
+        switch(fld.getField()->getType()) {
+        case pvd::scalar:
+            scalar(static_cast<pvd::PVScalar&>(fld));
+            break;
+        case pvd::scalarArray:
+            scalarArray(static_cast<pvd::PVScalarArray&>(fld));
+            break;
+        case pvd::structure:
+            structure(static_cast<pvd::PVStructure&>(fld), strict);
+            break;
+        case pvd::union_:
+            union_(static_cast<pvd::PVUnion&>(fld), strict);
+            mark(fld);
+            break;
+        case pvd::structureArray: {
+            pvd::PVStructureArray& F = static_cast<pvd::PVStructureArray&>(fld);
+            pvd::StructureConstPtr etype(F.getStructureArray()->getStructure());
+            pvd::PVStructureArray::svector arr;
+            pvd::BitSet *save = changed;
+            changed = 0;
+
+            expect('[');
+            if(peek()==']') {
+                pos++;
+            } else {
+                do {
+                    if(peek()=='n' && keyword("null")) {
+                        arr.push_back(pvd::PVStructurePtr());
+                    } else {
+                        pvd::PVStructurePtr elem(pvd::getPVDataCreate()->createPVStructure(etype));
+                        structure(*elem, strict);
+                        arr.push_back(elem);
+                    }
+                } while(!next(']'));
+            }
+            changed = save;
+            F.replace(pvd::freeze(arr));
+            mark(fld);
+        }
+            break;
+        case pvd::unionArray: {
+            pvd::PVUnionArray& F = static_cast<pvd::PVUnionArray&>(fld);
+            pvd::UnionConstPtr etype(F.getUnionArray()->getUnion());
+            pvd::PVUnionArray::svector arr;
+
+            expect('[');
+            if(peek()==']') {
+                pos++;
+            } else {
+                do {
+                    pvd::PVUnionPtr elem(pvd::getPVDataCreate()->createPVUnion(etype));
+                    union_(*elem, strict);
+                    arr.push_back(elem);
+                } while(!next(']'));
+            }
+            F.replace(pvd::freeze(arr));
+            mark(fld);
+        }
+            break;
+        }
+    }
+};
+
+} // namespace
+
+void p4p_to_json(std::string& out,
+                 const epics::pvData::PVStructure& val,
+                 const epics::pvData::BitSet* mask,
+                 P4PJSONNaN nanpolicy)
+{
+    Encoder E(out, nanpolicy);
+    // Offsets in 'mask' are relative to the top-most structure.
+    // 'val' is included entirely if it, or any parent, is marked.
+    bool all = !mask;
+    for(const pvd::PVStructure *S = &val; S && !all; S = S->getParent())
+        all = mask->get(S->getFieldOffset());
+    E.structure(val, mask, all);
+}
+
+void p4p_from_json(const char *buf, size_t len,
+                   epics::pvData::PVStructure& val,
+                   epics::pvData::BitSet* changed,
+                   bool strict)
+{
+    Decoder D(buf, len, changed);
+    D.structure(val, strict);
+    D.ws();
+    if(D.pos!=D.end)
+        D.fail("trailing characters");
+}
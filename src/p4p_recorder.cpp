@@ -0,0 +1,972 @@
+
+/* Recording of subscription updates to an append-only, self-describing, log file.
+ * Updates are serialized on pvAccess worker threads, without the GIL,
+ * and queued for a writer thread which performs all file I/O.
+ *
+ * All integers are little endian, and other fields use pvData serialization.
+ *
+ *   file := "P4PREC" 0x01 0x00 record*          (magic, format version, reserved)
+ *   record := kind(1) length(4) body(length)
+ *
+ *   'C'  id(4) name(string)
+ *   'T'  id(4) type(introspection)
+ *   'U'  id(4) seconds(8, POSIX) nanoseconds(4) full(1) changed(BitSet) overrun(BitSet) value
+ *   'E'  id(4) seconds(8, POSIX) nanoseconds(4) event(1) message(string)
+ *
+ * An 'U' value contains all fields if 'full', otherwise only those marked 'changed'.
+ * Each file is self contained.  'C' and 'T' precede the first 'U' or 'E' of a channel
+ * in each file, and a 'T' is repeated on type change.  The first 'U' after a 'T' is full.
+ * Readers should skip records of an unknown kind.
+ * A partial record at the end of an existing file (eg. after a crash) is truncated before appending.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+
+#ifdef _WIN32
+#  include <io.h>
+#else
+#  include <unistd.h>
+#endif
+
+#include <vector>
+#include <deque>
+#include <map>
+
+#include <epicsTime.h>
+#include <epicsEvent.h>
+
+#include <pv/serializeHelper.h>
+#include <pv/thread.h>
+#include <pva/client.h>
+
+#include "p4p.h"
+
+namespace pvd = epics::pvData;
+
+typedef PyClassWrapper<pvac::ClientChannel, true> PyClientChannel;
+// defined in p4p_client.cpp
+template<> PyTypeObject PyClassWrapper<pvac::ClientChannel, true>::type;
+
+namespace {
+
+const char recMagic[8] = {'P', '4', 'P', 'R', 'E', 'C', 1, 0};
+
+// body of a record to be written
+struct RecordOut : public pvd::Serializable {
+    char kind;
+    epicsUInt32 id;
+    epicsTimeStamp time;
+    // 'C' and 'E'
+    const std::string *str;
+    // 'T'
+    pvd::StructureConstPtr type;
+    // 'U'
+    bool full;
+    const pvd::BitSet *changed, *overrun;
+    const pvd::PVStructure *value;
+    // 'E'
+    int event;
+
+    RecordOut(char kind, epicsUInt32 id) :kind(kind), id(id), str(0), full(false), changed(0), overrun(0), value(0), event(0)
+    {
+        epicsTimeGetCurrent(&time);
+    }
+    virtual ~RecordOut() {}
+
+    virtual void serialize(pvd::ByteBuffer *buf, pvd::SerializableControl *ctrl) const OVERRIDE FINAL
+    {
+        ctrl->ensureBuffer(4);
+        buf->putInt(id);
+
+        if(kind=='U' || kind=='E') {
+            ctrl->ensureBuffer(13);
+            buf->putLong(pvd::int64(time.secPastEpoch) + POSIX_TIME_AT_EPICS_EPOCH);
+            buf->putInt(time.nsec);
+            buf->putByte(kind=='U' ? full : event);
+        }
+
+        switch(kind) {
+        case 'C':
+            pvd::SerializeHelper::serializeString(*str, buf, ctrl);
+            break;
+        case 'T':
+            ctrl->cachedSerialize(type, buf);
+            break;
+        case 'U':
+            changed->serialize(buf, ctrl);
+            overrun->serialize(buf, ctrl);
+            if(full)
+                value->serialize(buf, ctrl);
+            else
+                value->serialize(buf, ctrl, changed);
+            break;
+        case 'E':
+            pvd::SerializeHelper::serializeString(*str, buf, ctrl);
+            break;
+        }
+    }
+
+    virtual void deserialize(pvd::ByteBuffer *buf, pvd::DeserializableControl *ctrl) OVERRIDE FINAL
+    {
+        throw std::logic_error("RecordOut::deserialize not implemented");
+    }
+};
+
+struct Recorder {
+    struct Chan : public pvac::ClientChannel::MonitorCallback {
+        Recorder *owner;
+        epicsUInt32 id;
+        std::string name;
+        pvac::ClientChannel channel;
+        pvac::Monitor monitor;
+
+        // guarded by owner->lock
+        // set after 'monitor' is assigned
+        bool ready;
+        // set after a record was dropped, so that the next update is full
+        bool resync;
+        // union of all updates, to begin a new file with a full update
+        pvd::PVStructurePtr current;
+        // generation of file where 'C' and 'T' were queued
+        size_t gen;
+        pvd::StructureConstPtr written;
+
+        Chan() :owner(0), id(0), ready(false), resync(false), gen(0) {}
+        virtual ~Chan() {}
+
+        virtual void monitorEvent(const pvac::MonitorEvent& evt) OVERRIDE FINAL
+        {
+            Guard G(owner->lock);
+            if(!ready)
+                return; // Recorder::start() will catch up
+
+            if(evt.event==pvac::MonitorEvent::Data) {
+                while(monitor.poll())
+                    owner->update(*this);
+            } else {
+                owner->event(*this, evt);
+            }
+        }
+    };
+
+    // serialized records, or a request to the writer thread
+    struct Block {
+        enum kind_t {
+            Records,
+            Rotate, // close current file, rotate, and open a new one
+            Flush,  // fflush(), then set flushed=seq
+        } kind;
+        size_t seq;
+        std::vector<epicsUInt8> data;
+        Block() :kind(Records), seq(0u) {}
+    };
+
+    epicsMutex lock;
+
+    // not resized after start()
+    std::vector<Chan> chans;
+
+    // guarded by lock
+    std::string filename;
+    size_t maxsize;
+    unsigned maxfiles;
+    size_t maxqueue; // limit on queued bytes
+
+    // only accessed by writer thread after start()
+    FILE *fp;
+
+    // guarded by lock
+    size_t size; // of current file, including queued records
+    size_t gen;  // incremented when a file is begun
+    // when set, recording has stopped due to this error
+    std::string error;
+    std::vector<epicsUInt8> scratch;
+
+    // guarded by lock.  Records waiting for the writer thread
+    std::deque<Block> queue;
+    size_t queued; // bytes in queue
+    bool running;
+    size_t flushReq, flushed;
+    epicsEvent wakeup, // signaled when queue becomes non-empty, or !running
+               flushDone;
+    pvd::Thread writer;
+    bool started;
+
+    struct Stats {
+        size_t updates, events, dropped, bytes, files;
+        Stats() :updates(0u), events(0u), dropped(0u), bytes(0u), files(0u) {}
+    } stats;
+
+    Recorder()
+        :maxsize(0u), maxfiles(1u), maxqueue(16u<<20u), fp(0), size(0u), gen(0u), queued(0u)
+        ,running(true), flushReq(0u), flushed(0u)
+        ,writer(pvd::Thread::Config(this, &Recorder::run)
+                .name("P4P Recorder")
+                .autostart(false))
+        ,started(false)
+    {}
+    ~Recorder() {
+        close();
+    }
+
+    // call without GIL
+    void start(const pvd::PVStructure::const_shared_pointer& pvRequest)
+    {
+        {
+            Guard G(lock);
+            openFile();
+            if(fp)
+                size = fileSize();
+            if(!error.empty())
+                throw std::runtime_error(error);
+        }
+
+        writer.start();
+        started = true;
+
+        for(size_t i=0; i<chans.size(); i++) {
+            Chan& C = chans[i];
+            C.owner = this;
+            C.id = i;
+            C.monitor = C.channel.monitor(&C, pvRequest);
+
+            Guard G(lock);
+            C.ready = true;
+            // any Data event before 'ready' was ignored
+            while(C.monitor.poll())
+                update(C);
+        }
+    }
+
+    // call without GIL.  No updates are recorded after return.
+    // Records already queued are written.
+    void close()
+    {
+        for(size_t i=0; i<chans.size(); i++)
+            chans[i].monitor.cancel();
+
+        {
+            Guard G(lock);
+            running = false;
+        }
+        wakeup.signal();
+        if(started)
+            writer.exitWait();
+        started = false;
+
+        if(fp) {
+            FILE *F = fp;
+            fp = 0;
+            if(fclose(F)!=0) {
+                Guard G(lock);
+                fail("close");
+            }
+        }
+    }
+
+    // call without GIL.  Returns after all records queued before the call are written.
+    void flush()
+    {
+        Guard G(lock);
+        if(!running || !error.empty())
+            return;
+
+        const size_t seq = ++flushReq;
+        queue.push_back(Block());
+        queue.back().kind = Block::Flush;
+        queue.back().seq = seq;
+        wakeup.signal();
+
+        while(flushed<seq && running && error.empty()) {
+            UnGuard U(G);
+            flushDone.wait(0.1);
+        }
+    }
+
+    // call with lock held
+    void fail(const char *op)
+    {
+        if(error.empty())
+            error = SB()<<"Recorder "<<op<<" '"<<filename<<"' : "<<strerror(errno);
+    }
+
+    // Size of a valid recording in 'fp', not including any partial record at the end
+    // (eg. after a crash), or zero if empty.  Sets 'error' if not a recording.
+    // call with lock held, before the writer thread is started
+    size_t fileSize()
+    {
+        if(fseek(fp, 0, SEEK_END)!=0) {
+            fail("seek");
+            return 0u;
+        }
+        const long end = ftell(fp);
+        if(end<0) {
+            fail("seek");
+            return 0u;
+        } else if(end==0) {
+            return 0u;
+        }
+
+        char magic[sizeof(recMagic)];
+        if(fseek(fp, 0, SEEK_SET)!=0 || fread(magic, sizeof(magic), 1, fp)!=1 || memcmp(magic, recMagic, 7)!=0) {
+            error = SB()<<"Recorder '"<<filename<<"' exists, and is not a recording";
+            return 0u;
+        }
+
+        size_t pos = sizeof(recMagic);
+        epicsUInt8 head[5];
+        while(fread(head, sizeof(head), 1, fp)==1) {
+            const size_t blen = size_t(head[1]) | size_t(head[2])<<8u | size_t(head[3])<<16u | size_t(head[4])<<24u;
+            if(size_t(end) - pos - sizeof(head) < blen || fseek(fp, long(blen), SEEK_CUR)!=0)
+                break;
+            pos += sizeof(head) + blen;
+        }
+
+        if(pos!=size_t(end)) {
+            // discard partial record, which would otherwise hide all which follow
+            fflush(fp);
+            int ret;
+#ifdef _WIN32
+            ret = _chsize(_fileno(fp), long(pos));
+#else
+            ret = ftruncate(fileno(fp), off_t(pos));
+#endif
+            if(ret!=0) {
+                fail("truncate");
+                return 0u;
+            }
+        }
+
+        if(fseek(fp, 0, SEEK_END)!=0) {
+            fail("seek");
+            return 0u;
+        }
+        return pos;
+    }
+
+    // open 'filename' for append, and write magic if empty.
+    // call from writer thread, or with lock held before start()
+    void openFile()
+    {
+        FILE *F = fopen(filename.c_str(), "a+b");
+        if(!F) {
+            Guard G(lock);
+            fail("open");
+            return;
+        }
+        // only flushed when full, or by flush() or close()
+        setvbuf(F, 0, _IOFBF, 64u*1024u);
+
+        if(fseek(F, 0, SEEK_END)!=0) {
+            fclose(F);
+            Guard G(lock);
+            fail("seek");
+            return;
+        }
+
+        if(ftell(F)==0 && fwrite(recMagic, sizeof(recMagic), 1, F)!=1) {
+            fclose(F);
+            Guard G(lock);
+            fail("write");
+            return;
+        }
+        fp = F;
+    }
+
+    // call from writer thread
+    void rotate()
+    {
+        FILE *F = fp;
+        fp = 0;
+        if(fclose(F)!=0) {
+            Guard G(lock);
+            fail("close");
+            return;
+        }
+
+        std::string filename;
+        unsigned maxfiles;
+        {
+            Guard G(lock);
+            filename = this->filename;
+            maxfiles = this->maxfiles;
+            stats.files++;
+        }
+
+        // eg. with maxfiles=2, 'name.1' -> 'name.2' and 'name' -> 'name.1'
+        for(unsigned n=maxfiles; n>0u; n--) {
+            std::string dst(SB()<<filename<<'.'<<n);
+            std::string src(n>1u ? std::string(SB()<<filename<<'.'<<(n-1u)) : filename);
+            (void)remove(dst.c_str()); // rename() may not replace
+            (void)rename(src.c_str(), dst.c_str());
+        }
+        if(maxfiles==0u)
+            (void)remove(filename.c_str());
+
+        openFile();
+    }
+
+    // writer thread.  Performs all file I/O after start(), without lock held.
+    void run()
+    {
+        Guard G(lock);
+        while(true) {
+            if(queue.empty()) {
+                if(!running)
+                    break;
+                UnGuard U(G);
+                wakeup.wait();
+                continue;
+            }
+
+            Block blk;
+            blk.kind = queue.front().kind;
+            blk.seq = queue.front().seq;
+            blk.data.swap(queue.front().data);
+            queue.pop_front();
+            queued -= blk.data.size();
+
+            if(!error.empty())
+                continue; // discard
+
+            {
+                UnGuard U(G);
+                switch(blk.kind) {
+                case Block::Records:
+                    if(fp && !blk.data.empty() && fwrite(&blk.data[0], blk.data.size(), 1, fp)!=1) {
+                        Guard G2(lock);
+                        fail("write");
+                    }
+                    break;
+                case Block::Rotate:
+                    if(fp)
+                        rotate();
+                    break;
+                case Block::Flush:
+                    if(fp && fflush(fp)!=0) {
+                        Guard G2(lock);
+                        fail("flush");
+                    }
+                    break;
+                }
+            }
+
+            if(blk.kind==Block::Records && error.empty())
+                stats.bytes += blk.data.size();
+            if(blk.kind==Block::Flush) {
+                flushed = blk.seq;
+                flushDone.signal();
+            }
+            if(!error.empty()) {
+                // recording stopped.  wake any flush() waiter
+                flushDone.signal();
+            }
+        }
+    }
+
+    // call with lock held.  Serialize and append a record to 'scratch'
+    void append(const RecordOut& rec)
+    {
+        const size_t hpos = scratch.size();
+        scratch.resize(hpos+5u);
+        std::vector<epicsUInt8> body;
+        pvd::serializeToVector(&rec, EPICS_ENDIAN_LITTLE, body);
+
+        const size_t blen = body.size();
+        scratch[hpos] = epicsUInt8(rec.kind);
+        scratch[hpos+1] = epicsUInt8(blen);
+        scratch[hpos+2] = epicsUInt8(blen>>8u);
+        scratch[hpos+3] = epicsUInt8(blen>>16u);
+        scratch[hpos+4] = epicsUInt8(blen>>24u);
+        scratch.insert(scratch.end(), body.begin(), body.end());
+    }
+
+    // call with lock held.  Queue 'scratch' for the writer thread,
+    // or return false if the queue is full.
+    bool enqueue()
+    {
+        if(queued + scratch.size() > maxqueue)
+            return false;
+
+        queue.push_back(Block());
+        queue.back().data.swap(scratch);
+        const size_t blen = queue.back().data.size();
+        queued += blen;
+        size += blen;
+        if(queue.size()==1u)
+            wakeup.signal();
+        return true;
+    }
+
+    // Serialize an update (if 'value') or event of C, preceded by any 'C' and 'T' needed
+    // for the current file.  call with lock held.
+    void record(Chan& C, const pvd::StructureConstPtr& type, char kind,
+                const pvd::PVStructure *value, const pvac::MonitorEvent *evt)
+    {
+        if(!error.empty() || !running)
+            return; // not recording
+
+        if(maxsize && size>=maxsize && size>sizeof(recMagic)) {
+            // the writer thread begins a new file.  never dropped
+            queue.push_back(Block());
+            queue.back().kind = Block::Rotate;
+            if(queue.size()==1u)
+                wakeup.signal();
+            size = sizeof(recMagic);
+            gen++;
+        }
+
+        const bool newfile = C.gen!=gen;
+        const bool typed = type && (newfile || C.written!=type);
+
+        scratch.clear();
+        if(newfile) {
+            RecordOut rec('C', C.id);
+            rec.str = &C.name;
+            append(rec);
+        }
+        if(typed) {
+            RecordOut rec('T', C.id);
+            rec.type = type;
+            append(rec);
+        }
+
+        if(kind=='U') {
+            // begin each file, follow each type change, and any dropped update, with a full update
+            const bool full = typed || C.resync;
+            RecordOut rec('U', C.id);
+            rec.full = full;
+            rec.changed = &C.monitor.changed;
+            rec.overrun = &C.monitor.overrun;
+            rec.value = full ? C.current.get() : value;
+            append(rec);
+        } else {
+            RecordOut rec('E', C.id);
+            rec.event = evt->event;
+            rec.str = &evt->message;
+            append(rec);
+        }
+
+        if(!enqueue()) {
+            stats.dropped++;
+            if(kind=='U')
+                C.resync = true;
+            return;
+        }
+
+        if(newfile) {
+            C.gen = gen;
+            C.written.reset();
+        }
+        if(typed)
+            C.written = type;
+        if(kind=='U') {
+            C.resync = false;
+            stats.updates++;
+        } else {
+            stats.events++;
+        }
+    }
+
+    // record the update last poll()'d.  call with lock held
+    void update(Chan& C)
+    {
+        const pvd::PVStructure& root = *C.monitor.root;
+        const pvd::StructureConstPtr& type = root.getStructure();
+
+        if(!C.current || C.current->getStructure()!=type) {
+            C.current = pvd::getPVDataCreate()->createPVStructure(type);
+            C.current->copyUnchecked(root);
+        } else {
+            C.current->copyUnchecked(root, C.monitor.changed);
+        }
+
+        record(C, type, 'U', &root, 0);
+    }
+
+    // call with lock held
+    void event(Chan& C, const pvac::MonitorEvent& evt)
+    {
+        record(C, pvd::StructureConstPtr(), 'E', 0, &evt);
+    }
+
+    EPICS_NOT_COPYABLE(Recorder)
+};
+
+// Reads records from a buffer (eg. mmap) holding a recording.
+struct RecordReader {
+    struct Chan {
+        std::string name;
+        pvd::PVStructurePtr current;
+        // storage of the Value last returned, which read() will re-use
+        std::tr1::weak_ptr<P4PValueRoot> lent;
+
+        // copy out the Value last returned, if still referenced.  call with GIL locked
+        void reclaim() {
+            std::tr1::shared_ptr<P4PValueRoot> R(lent.lock());
+            if(R)
+                R->detach();
+            lent.reset();
+        }
+    };
+
+    Py_buffer view;
+    bool have;
+    size_t pos;
+    std::map<epicsUInt32, Chan> chans;
+
+    RecordReader() :have(false), pos(0u) {}
+    ~RecordReader() {
+        release();
+    }
+
+    void release() {
+        if(have)
+            PyBuffer_Release(&view);
+        have = false;
+    }
+
+    EPICS_NOT_COPYABLE(RecordReader)
+};
+
+// decode the body of a record.  call with GIL locked
+struct RecordIn : public pvd::Serializable {
+    RecordReader& R;
+    const char kind;
+
+    RecordReader::Chan *chan;
+    double time;
+    bool full;
+    int event;
+    std::string message;
+    pvd::BitSet::shared_pointer changed, overrun;
+
+    RecordIn(RecordReader& R, char kind) :R(R), kind(kind), chan(0), time(0.0), full(false), event(0) {}
+    virtual ~RecordIn() {}
+
+    virtual void serialize(pvd::ByteBuffer *buf, pvd::SerializableControl *ctrl) const OVERRIDE FINAL
+    {
+        throw std::logic_error("RecordIn::serialize not implemented");
+    }
+
+    virtual void deserialize(pvd::ByteBuffer *buf, pvd::DeserializableControl *ctrl) OVERRIDE FINAL
+    {
+        ctrl->ensureData(4);
+        chan = &R.chans[buf->getInt()];
+
+        if(kind=='U' || kind=='E') {
+            ctrl->ensureData(13);
+            pvd::int64 sec = buf->getLong();
+            pvd::uint32 nsec = buf->getInt();
+            time = double(sec) + nsec*1e-9;
+            if(kind=='U')
+                full = buf->getByte()!=0;
+            else
+                event = buf->getByte();
+        }
+
+        switch(kind) {
+        case 'C':
+            chan->name = pvd::SerializeHelper::deserializeString(buf, ctrl);
+            break;
+        case 'T': {
+            pvd::FieldConstPtr type(ctrl->cachedDeserialize(buf));
+            if(!type || type->getType()!=pvd::structure)
+                throw std::runtime_error("Recorded type is not a structure");
+
+            chan->reclaim();
+            chan->current = pvd::getPVDataCreate()->createPVStructure(std::tr1::static_pointer_cast<const pvd::Structure>(type));
+        }
+            break;
+        case 'U':
+            if(!chan->current)
+                throw std::runtime_error("Recorded update without type");
+
+            changed.reset(new pvd::BitSet);
+            overrun.reset(new pvd::BitSet);
+            changed->deserialize(buf, ctrl);
+            overrun->deserialize(buf, ctrl);
+
+            // 'current' may still be referenced by the previous Value
+            chan->reclaim();
+            if(full)
+                chan->current->deserialize(buf, ctrl);
+            else
+                chan->current->deserialize(buf, ctrl, changed.get());
+            break;
+        case 'E':
+            message = pvd::SerializeHelper::deserializeString(buf, ctrl);
+            break;
+        }
+    }
+};
+
+typedef PyClassWrapper<Recorder, true> PyRecorder;
+typedef PyClassWrapper<RecordReader> PyRecordReader;
+
+} // namespace
+
+PyClassWrapper_DEF(PyRecorder, "Recorder")
+PyClassWrapper_DEF(PyRecordReader, "RecordReader")
+
+namespace {
+
+#define TRY PyRecorder::reference_type SELF = PyRecorder::unwrap(self); try
+
+static int recorder_init(PyObject *self, PyObject *args, PyObject *kws)
+{
+    TRY {
+        static const char* names[] = {"channels", "filename", "pvRequest", "maxsize", "maxfiles", "maxqueue", NULL};
+        PyObject *pychans, *pvReq = Py_None;
+        const char *fname;
+        unsigned long long maxsize = 0u, maxqueue = 16u<<20u;
+        unsigned maxfiles = 1u;
+        if(!PyArg_ParseTupleAndKeywords(args, kws, "Os|OKIK", (char**)names,
+                                        &pychans, &fname, &pvReq, &maxsize, &maxfiles, &maxqueue))
+            return -1;
+
+        if(!SELF.chans.empty()) {
+            PyErr_SetString(PyExc_RuntimeError, "Already started");
+            return -1;
+        }
+
+        pvd::PVStructure::const_shared_pointer pvRequest;
+        if(pvReq!=Py_None)
+            pvRequest = P4PValue_unwrap(pvReq);
+
+        PyRef chans(PySequence_Fast(pychans, "channels must be a sequence"));
+        const size_t n = PySequence_Fast_GET_SIZE(chans.get());
+
+        SELF.chans.resize(n);
+        for(size_t i=0; i<n; i++) {
+            PyObject *chan = PySequence_Fast_GET_ITEM(chans.get(), i);
+            if(!PyObject_TypeCheck(chan, &PyClientChannel::type)) {
+                PyErr_Format(PyExc_TypeError, "channels[%u] must be ClientChannel", unsigned(i));
+                return -1;
+            }
+            SELF.chans[i].channel = PyClientChannel::unwrap(chan);
+            SELF.chans[i].name = SELF.chans[i].channel.name();
+        }
+
+        SELF.filename = fname;
+        SELF.maxsize = size_t(maxsize);
+        SELF.maxfiles = maxfiles;
+        SELF.maxqueue = size_t(maxqueue);
+
+        {
+            PyUnlock U;
+            SELF.start(pvRequest);
+        }
+
+        return 0;
+    }CATCH()
+    return -1;
+}
+
+static PyObject *recorder_close(PyObject *self)
+{
+    TRY {
+        std::string error;
+        {
+            PyUnlock U;
+            SELF.close();
+            Guard G(SELF.lock);
+            error = SELF.error;
+        }
+        if(!error.empty())
+            return PyErr_Format(PyExc_IOError, "%s", error.c_str());
+        Py_RETURN_NONE;
+    }CATCH()
+    return 0;
+}
+
+static PyObject *recorder_flush(PyObject *self)
+{
+    TRY {
+        std::string error;
+        {
+            PyUnlock U;
+            SELF.flush();
+            Guard G(SELF.lock);
+            error = SELF.error;
+        }
+        if(!error.empty())
+            return PyErr_Format(PyExc_IOError, "%s", error.c_str());
+        Py_RETURN_NONE;
+    }CATCH()
+    return 0;
+}
+
+static PyObject *recorder_stats(PyObject *self)
+{
+    TRY {
+        Recorder::Stats stats;
+        std::string error;
+        {
+            PyUnlock U;
+            Guard G(SELF.lock);
+            stats = SELF.stats;
+            error = SELF.error;
+        }
+
+        PyRef pyerror;
+        if(error.empty())
+            pyerror.reset(Py_None, borrow());
+        else
+            pyerror.reset(PyUnicode_FromString(error.c_str()));
+
+        return Py_BuildValue("{snsnsnsnsnsO}",
+                             "updates", Py_ssize_t(stats.updates),
+                             "events", Py_ssize_t(stats.events),
+                             "dropped", Py_ssize_t(stats.dropped),
+                             "bytes", Py_ssize_t(stats.bytes),
+                             "files", Py_ssize_t(stats.files),
+                             "error", pyerror.get());
+    }CATCH()
+    return 0;
+}
+
+static PyMethodDef recorder_methods[] = {
+    {"close", (PyCFunction)&recorder_close, METH_NOARGS,
+     "close()\n"
+     "Cancel subscriptions, write queued records, and close the file.  Raises IOError if recording stopped due to an error."},
+    {"flush", (PyCFunction)&recorder_flush, METH_NOARGS,
+     "flush()\n"
+     "Wait for queued records to be written, and flush to file.  Raises IOError if recording stopped due to an error."},
+    {"stats", (PyCFunction)&recorder_stats, METH_NOARGS,
+     "stats() -> {'updates':0, 'events':0, 'dropped':0, 'bytes':0, 'files':0, 'error':None}\n"
+     "Number of updates and events queued for writing, records dropped because the queue was full,\n"
+     "bytes written, files opened, and the error which stopped recording."},
+    {NULL}
+};
+
+#undef TRY
+#define TRY PyRecordReader::reference_type SELF = PyRecordReader::unwrap(self); try
+
+static int recordreader_init(PyObject *self, PyObject *args, PyObject *kws)
+{
+    TRY {
+        static const char* names[] = {"buffer", NULL};
+        PyObject *buf;
+        if(!PyArg_ParseTupleAndKeywords(args, kws, "O", (char**)names, &buf))
+            return -1;
+
+        SELF.release();
+        if(PyObject_GetBuffer(buf, &SELF.view, PyBUF_SIMPLE))
+            return -1;
+        SELF.have = true;
+        SELF.pos = 0u;
+        SELF.chans.clear();
+
+        return 0;
+    }CATCH()
+    return -1;
+}
+
+static PyObject *recordreader_read(PyObject *self)
+{
+    TRY {
+        if(!SELF.have)
+            return PyErr_Format(PyExc_RuntimeError, "Closed");
+
+        const char *base = (const char*)SELF.view.buf;
+        const size_t total = SELF.view.len;
+
+        if(SELF.pos==0u) {
+            if(total < sizeof(recMagic))
+                Py_RETURN_NONE;
+            if(memcmp(base, recMagic, 7)!=0)
+                return PyErr_Format(PyExc_ValueError, "Not a recording, or unsupported format version");
+            SELF.pos = sizeof(recMagic);
+        }
+
+        while(true) {
+            // stop at a truncated record.  eg. still being written
+            if(total - SELF.pos < 5u)
+                Py_RETURN_NONE;
+
+            const epicsUInt8 *head = (const epicsUInt8*)base + SELF.pos;
+            const size_t blen = size_t(head[1]) | size_t(head[2])<<8u | size_t(head[3])<<16u | size_t(head[4])<<24u;
+            if(total - SELF.pos - 5u < blen)
+                Py_RETURN_NONE;
+
+            const char kind = head[0];
+            // we promise not to modify
+            pvd::ByteBuffer B(const_cast<char*>(base) + SELF.pos + 5u, blen, EPICS_ENDIAN_LITTLE);
+            SELF.pos += 5u + blen;
+
+            if(kind!='C' && kind!='T' && kind!='U' && kind!='E')
+                continue; // from a later format version
+
+            RecordIn rec(SELF, kind);
+            pvd::deserializeFromBuffer(&rec, B);
+
+            if(kind=='U') {
+                // share until modified, or until the next update of this channel
+                std::tr1::shared_ptr<P4PValueRoot> root(new P4PValueRoot(rec.chan->current, true, true));
+                if(!rec.overrun->isEmpty())
+                    root->overrun = rec.overrun;
+                rec.chan->lent = root;
+
+                PyRef value(P4PValue_wrap_shared(P4PValue_type, root, rec.changed));
+
+                return Py_BuildValue("sdisO", rec.chan->name.c_str(), rec.time,
+                                     int(pvac::MonitorEvent::Data), "", value.get());
+
+            } else if(kind=='E') {
+                return Py_BuildValue("sdisO", rec.chan->name.c_str(), rec.time,
+                                     rec.event, rec.message.c_str(), Py_None);
+            }
+        }
+    }CATCH()
+    return 0;
+}
+
+static PyObject *recordreader_close(PyObject *self)
+{
+    TRY {
+        SELF.release();
+        Py_RETURN_NONE;
+    }CATCH()
+    return 0;
+}
+
+static PyMethodDef recordreader_methods[] = {
+    {"read", (PyCFunction)&recordreader_read, METH_NOARGS,
+     "read() -> (name, time, event, message, Value|None) | None\n"
+     "Next update or event.  'event' is as passed to a ClientMonitor handler.\n"
+     "None at the end of the buffer, or before a partially written record.\n"
+     "A Value remains valid after the next read(), but is copied if still referenced."},
+    {"close", (PyCFunction)&recordreader_close, METH_NOARGS,
+     "close()\n"
+     "Release the buffer."},
+    {NULL}
+};
+
+#undef TRY
+
+} // namespace
+
+void p4p_recorder_register(PyObject *mod)
+{
+    PyRecorder::buildType();
+
+    PyRecorder::type.tp_flags = Py_TPFLAGS_DEFAULT|Py_TPFLAGS_BASETYPE;
+    PyRecorder::type.tp_init = &recorder_init;
+
+    PyRecorder::type.tp_methods = recorder_methods;
+
+    PyRecorder::finishType(mod, "Recorder");
+
+
+    PyRecordReader::buildType();
+
+    PyRecordReader::type.tp_flags = Py_TPFLAGS_DEFAULT|Py_TPFLAGS_BASETYPE;
+    PyRecordReader::type.tp_init = &recordreader_init;
+
+    PyRecordReader::type.tp_methods = recordreader_methods;
+
+    PyRecordReader::finishType(mod, "RecordReader");
+}
@@ -91,15 +91,18 @@ PyObject* p4p_serialize(PyObject *junk, PyObject *args, PyObject *kws)
 {
     try {
         PyObject* obj;
-        int BE = 0;
-        const char *names[] = {"object", "be", 0};
-        if(!PyArg_ParseTupleAndKeywords(args, kws, "O|p", (char**)names, &obj, &BE))
+        int BE = 0, delta = 0;
+        const char *names[] = {"object", "be", "delta", 0};
+        if(!PyArg_ParseTupleAndKeywords(args, kws, "O|pp", (char**)names, &obj, &BE, &delta))
             return 0;
 
         std::tr1::shared_ptr<const epics::pvData::Serializable> fld;
 
         if(PyObject_IsInstance(obj, (PyObject*)P4PType_type)) {
             fld = P4PType_unwrap(obj);
+
+        } else if(PyObject_IsInstance(obj, (PyObject*)P4PValue_type)) {
+            fld = P4PValue_serializer(obj, delta);
         }
 
         if(!fld)
@@ -115,6 +118,29 @@ PyObject* p4p_serialize(PyObject *junk, PyObject *args, PyObject *kws)
     return 0;
 }
 
+PyObject* p4p_deserialize(PyObject *junk, PyObject *args, PyObject *kws)
+{
+    try {
+        PyObject *data;
+        int BE = 0;
+        const char *names[] = {"data", "be", 0};
+        if(!PyArg_ParseTupleAndKeywords(args, kws, "O!|p", (char**)names, &PyBytes_Type, &data, &BE))
+            return 0;
+
+        // we promise not to modify
+        epics::pvData::ByteBuffer B(PyBytes_AS_STRING(data), PyBytes_GET_SIZE(data),
+                                    BE ? EPICS_ENDIAN_BIG : EPICS_ENDIAN_LITTLE);
+
+        PyRef ret(P4PValue_deserialize(B));
+
+        if(B.getRemaining()!=0)
+            return PyErr_Format(PyExc_ValueError, "%lu unused bytes after Value", (unsigned long)B.getRemaining());
+
+        return ret.release();
+    }CATCH()
+    return 0;
+}
+
 static struct PyMethodDef P4P_methods[] = {
     {"installProvider", (PyCFunction)p4p_add_provider, METH_VARARGS|METH_KEYWORDS,
      "installProvider(\"name\", provider)\n"
@@ -137,7 +163,12 @@ static struct PyMethodDef P4P_methods[] = {
      "Force lazy initialization which might cause false positives"
      " leaks in differential ref counter testing."},
     {"serialize", (PyCFunction)p4p_serialize, METH_VARARGS|METH_KEYWORDS,
-     "Serialize Type or Value to bytes"},
+     "serialize(object, be=False, delta=False) -> bytes\n"
+     "Serialize Type or Value to bytes.\n"
+     "A Value is serialized with its changed mask.  If delta=True, only changed fields are included."},
+    {"deserialize", (PyCFunction)p4p_deserialize, METH_VARARGS|METH_KEYWORDS,
+     "deserialize(data, be=False) -> Value\n"
+     "Reverse of serialize() for a Value."},
     {NULL}
 };
 
@@ -177,6 +208,7 @@ PyMOD(_p4p)
         p4p_server_sharedpv_register(mod.get());
         p4p_server_provider_register(mod.get());
         p4p_client_register(mod.get());
+        p4p_recorder_register(mod.get());
 
         PyModule_AddIntConstant(mod.get(), "logLevelAll", epics::pvAccess::logLevelAll);
         PyModule_AddIntConstant(mod.get(), "logLevelTrace", epics::pvAccess::logLevelTrace);
@@ -1,6 +1,9 @@
 
 #include <stddef.h>
 
+#include <map>
+#include <vector>
+
 #include "p4p.h"
 
 #define NO_IMPORT_ARRAY
@@ -134,6 +137,173 @@ void py2struct(pvd::FieldBuilderPtr& builder, PyObject *o)
     }
 }
 
+/* Cache of Structures built from a spec, keyed by a normalized form of that spec.
+ * Identical Type(...) calls, as made by the NT helpers, re-use one Structure,
+ * and one python Type while it exists.
+ * Entries hold only weak references.  Only accessed with the GIL held.
+ */
+struct TypeCacheEntry {
+    std::tr1::weak_ptr<const pvd::Structure> type;
+    // Structures whose address is part of the key
+    std::vector<std::tr1::weak_ptr<const pvd::Structure> > pinned;
+    // weakref to python Type, or NULL
+    PyRef pytype;
+
+    bool valid() const {
+        if(type.expired())
+            return false;
+        for(size_t i=0; i<pinned.size(); i++) {
+            if(pinned[i].expired())
+                return false;
+        }
+        return true;
+    }
+};
+
+typedef std::map<std::string, TypeCacheEntry> type_cache_t;
+// never free'd, as entries may outlive the interpreter
+type_cache_t *type_cache;
+size_t type_cache_prune = 64u;
+
+typedef std::vector<std::tr1::weak_ptr<const pvd::Structure> > pinned_t;
+
+// Append normalized spec.  Returns false if the spec can't be cached (eg. an iterator),
+// or is invalid, in which case py2struct() will report the error.
+bool spec_key(std::ostream& key, pinned_t& pinned, PyObject *o)
+{
+    if(!PyList_Check(o) && !PyTuple_Check(o))
+        return false;
+
+    key<<'[';
+    for(Py_ssize_t i=0, N=PySequence_Fast_GET_SIZE(o); i<N; i++) {
+        PyObject *ent = PySequence_Fast_GET_ITEM(o, i);
+
+        const char *name;
+        PyObject *val;
+        if(!PyTuple_Check(ent) || !PyArg_ParseTuple(ent, "sO", &name, &val)) {
+            PyErr_Clear();
+            return false;
+        }
+        key<<strlen(name)<<':'<<name;
+
+        if(PyObject_IsInstance(val, (PyObject*)&P4PType::type)) {
+            const pvd::StructureConstPtr& sub(P4PType::unwrap(val));
+            key<<'T'<<(const void*)sub.get();
+            pinned.push_back(sub);
+
+        } else if(PyBytes_Check(val)) {
+            key<<'P'<<PyBytes_AS_STRING(val);
+
+        } else if(PyUnicode_Check(val)) {
+            PyRef str(PyUnicode_AsASCIIString(val), allownull());
+            if(!str) {
+                PyErr_Clear();
+                return false;
+            }
+            key<<'P'<<PyBytes_AS_STRING(str.get());
+
+        } else {
+            const char *tkey, *tname;
+            PyObject *members;
+            if(!PyTuple_Check(val) || !PyArg_ParseTuple(val, "szO", &tkey, &tname, &members)) {
+                PyErr_Clear();
+                return false;
+            }
+            key<<'N'<<tkey<<'<';
+            if(tname)
+                key<<strlen(tname)<<':'<<tname;
+            key<<'>';
+            if(!spec_key(key, pinned, members))
+                return false;
+        }
+        key<<';';
+    }
+    key<<']';
+    return true;
+}
+
+bool type_key(std::string& key, pinned_t& pinned, PyObject *spec, const char *id, PyObject *base)
+{
+    std::ostringstream strm;
+    if(id)
+        strm<<strlen(id)<<':'<<id;
+    strm<<'|';
+    if(base!=Py_None) {
+        const pvd::StructureConstPtr& B(P4PType::unwrap(base));
+        strm<<(const void*)B.get();
+        pinned.push_back(B);
+    }
+    strm<<'|';
+    if(!spec_key(strm, pinned, spec))
+        return false;
+    key = strm.str();
+    return true;
+}
+
+TypeCacheEntry* type_cache_find(const std::string& key)
+{
+    if(!type_cache)
+        return 0;
+    type_cache_t::iterator it(type_cache->find(key));
+    if(it==type_cache->end() || !it->second.valid())
+        return 0;
+    return &it->second;
+}
+
+TypeCacheEntry& type_cache_add(const std::string& key)
+{
+    if(!type_cache)
+        type_cache = new type_cache_t;
+
+    if(type_cache->size()>=type_cache_prune) {
+        // forget about Structures which no longer exist
+        for(type_cache_t::iterator cur(type_cache->begin()), end(type_cache->end()); cur!=end;) {
+            type_cache_t::iterator next(cur);
+            ++next;
+            if(!cur->second.valid())
+                type_cache->erase(cur);
+            cur = next;
+        }
+        type_cache_prune = std::max(size_t(64u), 2u*type_cache->size());
+    }
+
+    TypeCacheEntry& ent = (*type_cache)[key];
+    ent.pinned.clear();
+    ent.pytype.reset();
+    return ent;
+}
+
+PyObject* P4PType_new(PyTypeObject *atype, PyObject *args, PyObject *kwds)
+{
+    // P4PType_wrap() passes no arguments
+    bool hasargs = (args && PyTuple_GET_SIZE(args)>0) || (kwds && PyDict_Size(kwds)>0);
+    if(atype==P4PType_type && hasargs) {
+        // re-use a live Type built from the same spec
+        try {
+            PyObject *spec;
+            const char *id = NULL;
+            PyObject *base = Py_None;
+            static const char *names[] = {"spec", "id", "base", NULL};
+            if(PyArg_ParseTupleAndKeywords(args, kwds, "O|zO!", (char**)names, &spec, &id, (PyObject*)&P4PType::type, &base)) {
+                std::string key;
+                pinned_t pinned;
+                TypeCacheEntry *ent = type_key(key, pinned, spec, id, base) ? type_cache_find(key) : 0;
+                if(ent && ent->pytype) {
+                    PyObject *existing = PyWeakref_GetObject(ent->pytype.get());
+                    if(existing && existing!=Py_None) {
+                        Py_INCREF(existing);
+                        return existing; // tp_init() will be a no-op
+                    }
+                }
+            }
+        } catch(std::exception&) {
+        }
+        // errors are reported by tp_init()
+        PyErr_Clear();
+    }
+    return P4PType::tp_new(atype, args, kwds);
+}
+
 int P4PType_init(PyObject *self, PyObject *args, PyObject *kwds)
 {
     PyObject *spec;
@@ -142,11 +312,27 @@ int P4PType_init(PyObject *self, PyObject *args, PyObject *kwds)
     static const char *names[] = {"spec", "id", "base", NULL};
     TRY {
         if(SELF.get())
-            return 0; // magic case when called from P4PType_wrap()
+            return 0; // magic case when called from P4PType_wrap(), or re-used by P4PType_new()
 
         if(!PyArg_ParseTupleAndKeywords(args, kwds, "O|zO!", (char**)names, &spec, &id, (PyObject*)&P4PType::type, &base))
             return -1;
 
+        std::string key;
+        pinned_t pinned;
+        bool cachable = type_key(key, pinned, spec, id, base);
+
+        if(cachable) {
+            TypeCacheEntry *ent = type_cache_find(key);
+            if(ent) {
+                SELF = ent->type.lock();
+                if(Py_TYPE(self)==P4PType_type && (!ent->pytype || PyWeakref_GetObject(ent->pytype.get())==Py_None)) {
+                    PyRef W(PyWeakref_NewRef(self, NULL));
+                    ent->pytype = W;
+                }
+                return 0;
+            }
+        }
+
         pvd::FieldBuilderPtr builder;
         if(base==Py_None)
             builder = pvd::getFieldCreate()->createFieldBuilder();
@@ -162,6 +348,16 @@ int P4PType_init(PyObject *self, PyObject *args, PyObject *kwds)
             return -1;
         }
 
+        if(cachable) {
+            TypeCacheEntry& ent = type_cache_add(key);
+            ent.type = SELF;
+            ent.pinned.swap(pinned);
+            if(Py_TYPE(self)==P4PType_type) {
+                PyRef W(PyWeakref_NewRef(self, NULL));
+                ent.pytype = W;
+            }
+        }
+
         return 0;
     }CATCH()
     return -1;
@@ -384,6 +580,52 @@ PyObject* P4PType_getitem(PyObject *self, PyObject *name)
     return NULL;
 }
 
+// Types built from the same spec share a Structure, so equality is usually a pointer comparison
+PyObject* P4PType_richcompare(PyObject *self, PyObject *other, int op)
+{
+    TRY {
+        if((op!=Py_EQ && op!=Py_NE) || !PyObject_TypeCheck(other, &P4PType::type))
+            Py_RETURN_NOTIMPLEMENTED;
+
+        const pvd::StructureConstPtr& O = P4PType::unwrap(other);
+
+        bool equal = SELF==O || (SELF && O && *SELF==*O);
+
+        if(equal ^ (op==Py_NE))
+            Py_RETURN_TRUE;
+        else
+            Py_RETURN_FALSE;
+    }CATCH()
+    return NULL;
+}
+
+#if PY_MAJOR_VERSION < 3
+typedef long Py_hash_t;
+#endif
+
+// consistent with P4PType_richcompare().  Equal Structures have the same ID and number of fields.
+Py_hash_t P4PType_hash(PyObject *self)
+{
+    TRY {
+        if(!SELF)
+            return 0;
+
+        // FNV-1a
+        size_t hash = 2166136261u;
+        const std::string& id = SELF->getID();
+        for(size_t i=0; i<id.size(); i++) {
+            hash ^= (unsigned char)id[i];
+            hash *= 16777619u;
+        }
+        hash ^= SELF->getNumberFields();
+        hash *= 16777619u;
+
+        Py_hash_t ret = Py_hash_t(hash);
+        return ret==-1 ? -2 : ret;
+    }CATCH()
+    return -1;
+}
+
 PyMappingMethods P4PType_mapping = {
     (lenfunc)&P4PType_len,
     (binaryfunc)&P4PType_getitem,
@@ -429,7 +671,10 @@ void p4p_type_register(PyObject *mod)
 {
     P4PType::buildType();
     P4PType::type.tp_flags = Py_TPFLAGS_DEFAULT|Py_TPFLAGS_BASETYPE|Py_TPFLAGS_HAVE_GC;
+    P4PType::type.tp_new = &P4PType_new;
     P4PType::type.tp_init = &P4PType_init;
+    P4PType::type.tp_richcompare = &P4PType_richcompare;
+    P4PType::type.tp_hash = &P4PType_hash;
     P4PType::type.tp_traverse = &P4PType_traverse;
     P4PType::type.tp_clear = &P4PType_clear;
 
@@ -485,7 +730,7 @@ epics::pvData::Field::const_shared_pointer P4PType_guess(PyObject *obj)
         return create->createScalar(pvd::pvDouble);
     } else if(PyBytes_Check(obj) || PyUnicode_Check(obj)) {
         return create->createScalar(pvd::pvString);
-    } else if(PyList_Check(obj)) {
+    } else if(PyList_Check(obj) || PyObject_TypeCheck(obj, P4PStringArray_type)) {
         return create->createScalarArray(pvd::pvString);
     } else if(PyArray_Check(obj)) {
         switch(PyArray_TYPE(obj)) {
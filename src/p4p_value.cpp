@@ -1,6 +1,18 @@
 
 #include <stddef.h>
 
+#include <map>
+
+#if __cplusplus>=201103L || (defined(_MSC_VER) && _MSC_VER>=1600)
+#  include <unordered_map>
+#  define P4P_UNORDERED_MAP std::unordered_map
+#else
+#  include <tr1/unordered_map>
+#  define P4P_UNORDERED_MAP std::tr1::unordered_map
+#endif
+
+#include <pv/typeCast.h>
+
 #include "p4p.h"
 
 #define NO_IMPORT_ARRAY
@@ -16,12 +28,113 @@ namespace {
 
 namespace pvd = epics::pvData;
 
+// store a Python object in a scalar field of a particular type.
+// returns false, without side-effects, when obj is not handled.
+typedef bool (*store_fn)(pvd::PVField* fld, PyObject *obj);
+
+// Compiled assignment from a dict with a particular set of keys,
+// in iteration order.  (see Value::store_struct())
+struct AssignPlan {
+    struct Entry {
+        PyObject *key; // strong ref.
+        size_t rel; // offset relative to the assigned structure
+        store_fn store; // NULL to always use Value::storefld()
+    };
+    std::vector<Entry> entries;
+
+    AssignPlan() {}
+    ~AssignPlan() {
+        for(size_t i=0; i<entries.size(); i++)
+            Py_DECREF(entries[i].key);
+    }
+
+    // does the dict have exactly our keys, in our order?
+    bool match(PyObject *dict) const;
+private:
+    EPICS_NOT_COPYABLE(AssignPlan)
+};
+
+// Index of the dotted names of all sub-fields of a Structure.
+// Shared by all Values of the same (interned) Structure.
+// Only accessed with the GIL held.
+struct FieldIndex {
+    const pvd::Structure *type;
+    std::tr1::weak_ptr<const pvd::Structure> weak;
+    // dict { 'dotted.name' : offset relative to top }
+    PyObject *names;
+    // tuple of the names of direct sub-fields, in order
+    PyObject *keys;
+    // tuple of dotted names by offset relative to top.  [0] is None
+    PyObject *offsets;
+    // recently used assignment plans.  most recent last
+    std::vector<std::tr1::shared_ptr<AssignPlan> > plans;
+
+    FieldIndex() :type(0), names(0), keys(0), offsets(0) {}
+    ~FieldIndex() { Py_XDECREF(names); Py_XDECREF(keys); Py_XDECREF(offsets); }
+
+    bool valid(const pvd::Structure *T) const { return type==T && !weak.expired(); }
+
+    static std::tr1::shared_ptr<FieldIndex> lookup(const pvd::PVStructure& top);
+
+    // find, or compile, the plan for assigning the keys of dict to the sub-fields of top.
+    std::tr1::shared_ptr<AssignPlan> plan(const pvd::PVStructure& top, PyObject *dict);
+private:
+    void build(const pvd::PVStructure& top, const pvd::PVStructure& S, const std::string& prefix);
+    EPICS_NOT_COPYABLE(FieldIndex)
+};
+
 struct Value {
     // structure we are wrapping
     pvd::PVStructure::shared_pointer V;
     // which fields of this structure have been initialized w/ non-default values
     // NULL when not tracking, treated as bit 0 set (aka all initialized)
     pvd::BitSet::shared_pointer I;
+    // cached name lookup for V->getStructure()
+    std::tr1::shared_ptr<FieldIndex> index;
+    // storage of V, shared with our parent and sub-structure Values.
+    // may be replaced by a private copy (see writable())
+    std::tr1::shared_ptr<P4PValueRoot> root;
+    // root->root when V was last resolved
+    const pvd::PVStructure *top;
+
+    Value() :top(0) {}
+
+    // re-resolve V if root has been copied since we last looked
+    Value& sync() {
+        if(root && top!=root->root.get()) {
+            size_t offset = V->getFieldOffset();
+            top = root->root.get();
+            if(offset==0)
+                V = root->root;
+            else
+                V = std::tr1::static_pointer_cast<pvd::PVStructure>(root->root->getSubField(offset));
+            assert(!!V);
+        }
+        return *this;
+    }
+
+    // ensure V may be modified without affecting any other Value
+    Value& writable() {
+        sync();
+        if(root && root->shared) {
+            // don't count our own reference when detach() checks whether the storage is still shared
+            if(V==root->root) {
+                V.reset();
+                root->detach();
+                V = root->root;
+                top = V.get();
+            } else {
+                root->detach();
+                sync();
+            }
+        }
+        return *this;
+    }
+
+    // find sub-field by dotted name.  NULL if no such field
+    pvd::PVFieldPtr lookup(PyObject *name);
+    // find sub-field by dotted name, but only if the index has it
+    pvd::PVFieldPtr lookup_fast(PyObject *name);
 
     // assignment of PVStructure from Object
 
@@ -57,19 +170,55 @@ struct Value {
                        const pvd::BitSet::shared_pointer& bset,
                        bool unpackstruct,
                        bool unpackrecurse=true,
-                       PyObject* wrapper=0);
+                       PyObject* wrapper=0,
+                       bool lazy=false);
+
+    // unpack structure as dict (or list of tuples when !wrapper).
+    // When mask!=NULL, only include fields with a bit set, or with a sub-field with a bit set.
+    PyObject *fetch_struct(pvd::PVStructure *fld,
+                           const pvd::BitSet::shared_pointer& bset,
+                           bool unpackrecurse,
+                           PyObject* wrapper,
+                           const pvd::BitSet *mask);
+
+    // bulk conversion of table-like fields to/from columns
+
+    PyObject *fetch_columns(pvd::PVField *fld, bool structured);
+
+    void store_columns(pvd::PVField *fld,
+                       PyObject *obj,
+                       const pvd::BitSet::shared_pointer& bset);
+};
+
+// State of Value.iterChanged().  Visits the changed mask one name at a time.
+struct ChangedIter {
+    pvd::PVStructure::shared_pointer V;
+    std::tr1::shared_ptr<FieldIndex> index;
+    // copy of the changed mask when iteration began
+    pvd::BitSet changed;
+    // field offsets [b0, b1) of V
+    size_t b0, b1;
+    // next offset to test
+    size_t next;
+    // all offsets before this are treated as changed.  eg. within an expanded sub-structure
+    size_t allUntil;
+    bool expand;
+
+    ChangedIter() :b0(0u), b1(0u), next(0u), allUntil(0u), expand(false) {}
 };
 
 }//namespace
 
 typedef PyClassWrapper<Value> P4PValue;
+typedef PyClassWrapper<ChangedIter> P4PChangedIter;
 
 
 PyClassWrapper_DEF(P4PValue, "Value")
+PyClassWrapper_DEF(P4PChangedIter, "ChangedIterator")
 
 namespace {
 
-#define TRY P4PValue::reference_type SELF = P4PValue::unwrap(self); try
+#define TRY P4PValue::reference_type SELF = P4PValue::unwrap(self).sync(); try
 
 struct npmap {
     NPY_TYPES npy;
@@ -96,6 +245,454 @@ NPY_TYPES ntype(pvd::ScalarType t) {
     throw std::runtime_error(SB()<<"Unable to map scalar type '"<<(int)t<<"'");
 }
 
+// numpy array references released by threads which don't hold the GIL.
+// Taking the GIL from within the deleter could deadlock with a thread which holds
+// the GIL while waiting on a lock held by the releasing thread (eg. a pvAccess worker).
+epicsMutex numpyReleaseLock;
+std::vector<PyObject*> numpyRelease; // guarded by numpyReleaseLock
+
+// call with GIL locked
+int numpyReleaseDrain(void *)
+{
+    std::vector<PyObject*> objs;
+    {
+        Guard G(numpyReleaseLock);
+        objs.swap(numpyRelease);
+    }
+    for(size_t i=0; i<objs.size(); i++)
+        Py_DECREF(objs[i]);
+    return 0;
+}
+
+// Deleter for a shared_vector which references numpy array storage.
+// Holds one reference to the array object, which may be released from any thread.
+struct NumpyRef {
+    PyObject *arr;
+    explicit NumpyRef(PyObject *arr) :arr(arr) {}
+    void operator()(const void*) {
+        if(!Py_IsInitialized())
+            return; // interpreter gone, leak
+#if PY_VERSION_HEX >= 0x03040000
+        if(PyGILState_Check()) {
+            Py_DECREF(arr);
+            return;
+        }
+#endif
+        bool first;
+        {
+            Guard G(numpyReleaseLock);
+            first = numpyRelease.empty();
+            numpyRelease.push_back(arr);
+        }
+        // may fail if the pending call queue is full.  Then drained by the next wrapNumpy()
+        if(first)
+            (void)Py_AddPendingCall(&numpyReleaseDrain, 0);
+    }
+};
+
+template<typename T>
+pvd::shared_vector<const void> wrapNumpy(PyObject *arr)
+{
+    PyArrayObject *A = (PyArrayObject*)arr;
+    (void)numpyReleaseDrain(0);
+    Py_INCREF(arr); // released by NumpyRef
+    std::tr1::shared_ptr<const T> data((const T*)PyArray_DATA(A), NumpyRef(arr));
+    pvd::shared_vector<const T> ret(data, 0, PyArray_DIM(A, 0));
+    return pvd::static_shared_vector_cast<const void>(ret);
+}
+
+// Whether the storage of a numpy array can never change.
+// The array, and every array it is a view of, must be read-only,
+// and the storage must belong to one of them, or to an immutable object.
+bool immutableArray(PyObject *arr, PyObject **owner)
+{
+    PyObject *cur = arr;
+    while(PyArray_Check(cur)) {
+        PyArrayObject *A = (PyArrayObject*)cur;
+        if(PyArray_ISWRITEABLE(A))
+            return false;
+        PyObject *base = PyArray_BASE(A);
+        if(!base) {
+            *owner = cur;
+            return PyArray_CHKFLAGS(A, NPY_OWNDATA);
+        }
+        cur = base;
+    }
+    *owner = cur;
+    return Py_TYPE(cur)==P4PArray_type || PyBytes_CheckExact(cur);
+}
+
+// Attempt to share the storage of a numpy array instead of copying.
+bool shareNumpy(PyObject *obj, pvd::ScalarType etype, NPY_TYPES nptype, pvd::shared_vector<const void>& out)
+{
+    PyObject *owner = 0;
+
+    if(!PyArray_Check(obj))
+        return false;
+    PyArrayObject *A = (PyArrayObject*)obj;
+
+    if(PyArray_NDIM(A)!=1
+            || !PyArray_ISCARRAY_RO(A)
+            || !PyArray_ISNOTSWAPPED(A)
+            || !PyArray_EquivTypenums(PyArray_TYPE(A), nptype)
+            || !immutableArray(obj, &owner))
+        return false;
+
+    if(Py_TYPE(owner)==P4PArray_type) {
+        // a (slice of) an array we previously exported.  Re-use the original vector.
+        const array_type& orig = P4PArray_extract(owner);
+        const char *start = (const char*)orig.data(),
+                   *mine  = (const char*)PyArray_DATA(A);
+        size_t nbytes = PyArray_NBYTES(A);
+
+        if(orig.original_type()==etype && mine>=start && mine+nbytes<=start+orig.size()) {
+            out = orig;
+            out.slice(mine-start, nbytes);
+            return true;
+        }
+    }
+
+    switch(etype) {
+    case pvd::pvBoolean: out = wrapNumpy<pvd::boolean>(obj); return true;
+    case pvd::pvByte:    out = wrapNumpy<pvd::int8>(obj); return true;
+    case pvd::pvShort:   out = wrapNumpy<pvd::int16>(obj); return true;
+    case pvd::pvInt:     out = wrapNumpy<pvd::int32>(obj); return true;
+    case pvd::pvLong:    out = wrapNumpy<pvd::int64>(obj); return true;
+    case pvd::pvUByte:   out = wrapNumpy<pvd::uint8>(obj); return true;
+    case pvd::pvUShort:  out = wrapNumpy<pvd::uint16>(obj); return true;
+    case pvd::pvUInt:    out = wrapNumpy<pvd::uint32>(obj); return true;
+    case pvd::pvULong:   out = wrapNumpy<pvd::uint64>(obj); return true;
+    case pvd::pvFloat:   out = wrapNumpy<float>(obj); return true;
+    case pvd::pvDouble:  out = wrapNumpy<double>(obj); return true;
+    default:
+        return false;
+    }
+}
+
+PyObject *internString(const std::string& s)
+{
+#if PY_MAJOR_VERSION < 3
+    PyObject *ret = PyString_InternFromString(s.c_str());
+#else
+    PyObject *ret = PyUnicode_InternFromString(s.c_str());
+#endif
+    if(!ret)
+        throw std::runtime_error("XXX");
+    return ret;
+}
+
+typedef std::map<const pvd::Structure*, std::tr1::shared_ptr<FieldIndex> > field_indicies_t;
+// never free'd, as entries may outlive the interpreter
+field_indicies_t *field_indicies;
+size_t field_indicies_prune = 64u;
+
+std::tr1::shared_ptr<FieldIndex> FieldIndex::lookup(const pvd::PVStructure& top)
+{
+    const pvd::StructureConstPtr& type(top.getStructure());
+
+    if(!field_indicies)
+        field_indicies = new field_indicies_t;
+
+    field_indicies_t::iterator it(field_indicies->find(type.get()));
+    if(it!=field_indicies->end() && it->second->valid(type.get()))
+        return it->second;
+
+    if(field_indicies->size()>=field_indicies_prune) {
+        // forget about Structures which no longer exist
+        for(field_indicies_t::iterator cur(field_indicies->begin()), end(field_indicies->end()); cur!=end;) {
+            field_indicies_t::iterator next(cur);
+            ++next;
+            if(cur->second->weak.expired())
+                field_indicies->erase(cur);
+            cur = next;
+        }
+        field_indicies_prune = std::max(size_t(64u), 2u*field_indicies->size());
+    }
+
+    std::tr1::shared_ptr<FieldIndex> ret(new FieldIndex);
+    ret->type = type.get();
+    ret->weak = type;
+    ret->names = PyDict_New();
+    ret->offsets = PyTuple_New(top.getNumberFields());
+    if(!ret->names || !ret->offsets)
+        throw std::runtime_error("XXX");
+    Py_INCREF(Py_None);
+    PyTuple_SET_ITEM(ret->offsets, 0, Py_None);
+    ret->build(top, top, std::string());
+
+    const pvd::StringArray& fnames(type->getFieldNames());
+    ret->keys = PyTuple_New(fnames.size());
+    if(!ret->keys)
+        throw std::runtime_error("XXX");
+    for(size_t i=0; i<fnames.size(); i++) {
+        PyTuple_SET_ITEM(ret->keys, i, internString(fnames[i]));
+    }
+
+    (*field_indicies)[type.get()] = ret;
+    return ret;
+}
+
+void FieldIndex::build(const pvd::PVStructure& top, const pvd::PVStructure& S, const std::string& prefix)
+{
+    const pvd::PVFieldPtrArray& flds(S.getPVFields());
+    const pvd::StringArray& fnames(S.getStructure()->getFieldNames());
+
+    for(size_t i=0; i<flds.size(); i++) {
+        std::string name(prefix+fnames[i]);
+        PyRef key(internString(name));
+        size_t rel = flds[i]->getFieldOffset() - top.getFieldOffset();
+        PyRef offset(PyLong_FromSize_t(rel));
+
+        if(PyDict_SetItem(names, key.get(), offset.get()))
+            throw std::runtime_error("XXX");
+        PyTuple_SET_ITEM(offsets, rel, key.release());
+
+        if(flds[i]->getField()->getType()==pvd::structure)
+            build(top, static_cast<const pvd::PVStructure&>(*flds[i]), name+".");
+    }
+}
+
+// Index of the strings of an enum_t choices array.
+// Keyed by the (shared, and normally immutable) array storage.
+// Only accessed with the GIL held.
+struct ChoiceIndex {
+    std::tr1::weak_ptr<const std::string> storage;
+    size_t count;
+    typedef P4P_UNORDERED_MAP<std::string, size_t> index_t;
+    index_t index;
+
+    ChoiceIndex() :count(0) {}
+
+    bool valid(const pvd::PVStringArray::const_svector& C) const {
+        return count==C.size() && storage.lock()==C.dataPtr();
+    }
+
+    // find the index of the first choice matching 'str'.  returns false if none.
+    static bool find(const pvd::PVStringArray::const_svector& C, const std::string& str, size_t *idx);
+};
+
+typedef std::map<const std::string*, std::tr1::shared_ptr<ChoiceIndex> > choice_indicies_t;
+// never free'd, as entries may outlive the interpreter
+choice_indicies_t *choice_indicies;
+size_t choice_indicies_prune = 64u;
+
+// shorter choice lists are simply searched
+static const size_t choice_index_min = 16u;
+
+bool ChoiceIndex::find(const pvd::PVStringArray::const_svector& C, const std::string& str, size_t *idx)
+{
+    if(C.size() >= choice_index_min) {
+        if(!choice_indicies)
+            choice_indicies = new choice_indicies_t;
+
+        std::tr1::shared_ptr<ChoiceIndex> ent;
+        choice_indicies_t::iterator it(choice_indicies->find(C.data()));
+        if(it!=choice_indicies->end() && it->second->valid(C))
+            ent = it->second;
+
+        if(!ent) {
+            if(choice_indicies->size()>=choice_indicies_prune) {
+                // forget about choices which no longer exist
+                for(choice_indicies_t::iterator cur(choice_indicies->begin()), end(choice_indicies->end()); cur!=end;) {
+                    choice_indicies_t::iterator next(cur);
+                    ++next;
+                    if(cur->second->storage.expired())
+                        choice_indicies->erase(cur);
+                    cur = next;
+                }
+                choice_indicies_prune = std::max(size_t(64u), 2u*choice_indicies->size());
+            }
+
+            ent.reset(new ChoiceIndex);
+            ent->storage = C.dataPtr();
+            ent->count = C.size();
+            for(size_t i=0; i<C.size(); i++)
+                ent->index.insert(std::make_pair(C[i], i)); // first match wins
+            (*choice_indicies)[C.data()] = ent;
+        }
+
+        index_t::const_iterator hit(ent->index.find(str));
+        // storage may have been modified in place (eg. by deserialization) if otherwise unreferenced.
+        // so check the hit, and confirm a miss below.
+        if(hit!=ent->index.end() && hit->second<C.size() && C[hit->second]==str) {
+            *idx = hit->second;
+            return true;
+        }
+    }
+
+    // search for matching choices string
+    for(size_t i=0; i<C.size(); i++) {
+        if(C[i]==str) {
+            *idx = i;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Typed equivalents of the common cases of Value::storefld() for scalars.
+// Conversions are the same as with PVScalar::putFrom()
+
+template<typename T>
+bool store_number(pvd::PVField* fld, PyObject *obj)
+{
+    T val;
+    if(PyFloat_CheckExact(obj)) {
+        val = pvd::castUnsafe<T, double>(PyFloat_AS_DOUBLE(obj));
+
+    } else if(PyLong_CheckExact(obj)) {
+        int oflow = 0;
+        long long temp = PyLong_AsLongLongAndOverflow(obj, &oflow);
+        if(oflow || (temp==-1 && PyErr_Occurred())) {
+            PyErr_Clear();
+            return false; // storefld() knows what to do
+        }
+        val = pvd::castUnsafe<T, pvd::int64>(temp);
+
+    } else {
+        return false;
+    }
+    static_cast<pvd::PVScalarValue<T>*>(fld)->put(val);
+    return true;
+}
+
+bool store_string(pvd::PVField* fld, PyObject *obj)
+{
+    if(PyBytes_CheckExact(obj)) {
+        static_cast<pvd::PVString*>(fld)->put(std::string(PyBytes_AS_STRING(obj), PyBytes_GET_SIZE(obj)));
+
+    } else if(PyUnicode_CheckExact(obj)) {
+        PyRef B(PyUnicode_AsUTF8String(obj));
+        static_cast<pvd::PVString*>(fld)->put(std::string(PyBytes_AS_STRING(B.get()), PyBytes_GET_SIZE(B.get())));
+
+    } else {
+        return false;
+    }
+    return true;
+}
+
+store_fn select_store(const pvd::Field* ftype)
+{
+    if(ftype->getType()!=pvd::scalar)
+        return 0;
+
+    switch(static_cast<const pvd::Scalar*>(ftype)->getScalarType()) {
+    case pvd::pvBoolean: return &store_number<pvd::boolean>;
+    case pvd::pvByte:    return &store_number<pvd::int8>;
+    case pvd::pvShort:   return &store_number<pvd::int16>;
+    case pvd::pvInt:     return &store_number<pvd::int32>;
+    case pvd::pvLong:    return &store_number<pvd::int64>;
+    case pvd::pvUByte:   return &store_number<pvd::uint8>;
+    case pvd::pvUShort:  return &store_number<pvd::uint16>;
+    case pvd::pvUInt:    return &store_number<pvd::uint32>;
+    case pvd::pvULong:   return &store_number<pvd::uint64>;
+    case pvd::pvFloat:   return &store_number<float>;
+    case pvd::pvDouble:  return &store_number<double>;
+    case pvd::pvString:  return &store_string;
+    }
+    return 0;
+}
+
+bool AssignPlan::match(PyObject *dict) const
+{
+    if(PyDict_Size(dict)!=Py_ssize_t(entries.size()))
+        return false;
+
+    Py_ssize_t n=0;
+    PyObject *K, *V;
+    for(size_t i=0; PyDict_Next(dict, &n, &K, &V); i++) {
+        PyObject *expect = entries[i].key;
+        if(K==expect)
+            continue; // common case of literal, or otherwise interned, keys
+        if(Py_TYPE(K)!=Py_TYPE(expect))
+            return false;
+        int eq = PyObject_RichCompareBool(K, expect, Py_EQ);
+        if(eq<0)
+            throw std::runtime_error("XXX");
+        else if(!eq)
+            return false;
+    }
+    return true;
+}
+
+// limit on plans per Structure
+static const size_t max_plans = 4u;
+
+std::tr1::shared_ptr<AssignPlan> FieldIndex::plan(const pvd::PVStructure& top, PyObject *dict)
+{
+    for(size_t i=plans.size(); i; i--) {
+        if(plans[i-1]->match(dict)) {
+            std::tr1::shared_ptr<AssignPlan> ret(plans[i-1]);
+            if(i!=plans.size()) {
+                plans.erase(plans.begin()+i-1);
+                plans.push_back(ret);
+            }
+            return ret;
+        }
+    }
+
+    std::tr1::shared_ptr<AssignPlan> ret(new AssignPlan);
+    ret->entries.reserve(PyDict_Size(dict));
+
+    Py_ssize_t n=0;
+    PyObject *K, *V;
+    while(PyDict_Next(dict, &n, &K, &V)) {
+        pvd::PVFieldPtr F;
+
+        // borrowed ref
+        PyObject *offset = PyDict_GetItem(names, K);
+        if(offset) {
+            F = top.getSubField(top.getFieldOffset() + PyLong_AsSize_t(offset));
+        } else {
+            // eg. bytes key with py3, or no such field
+            PyString key(K);
+            F = top.getSubField(key.str());
+            if(!F) {
+                PyErr_Format(PyExc_KeyError, "no sub-field %s.%s", top.getFullName().c_str(), key.str().c_str());
+                throw std::runtime_error("not seen");
+            }
+        }
+
+        AssignPlan::Entry ent;
+        ent.rel = F->getFieldOffset() - top.getFieldOffset();
+        ent.store = select_store(F->getField().get());
+        ent.key = K;
+        Py_INCREF(K);
+        ret->entries.push_back(ent);
+    }
+
+    if(plans.size()>=max_plans)
+        plans.erase(plans.begin());
+    plans.push_back(ret);
+    return ret;
+}
+
+pvd::PVFieldPtr Value::lookup_fast(PyObject *name)
+{
+    pvd::PVFieldPtr ret;
+    const pvd::Structure *type = V->getStructure().get();
+
+    if(!index || !index->valid(type))
+        index = FieldIndex::lookup(*V);
+
+    // borrowed ref.  Interned keys are matched by pointer comparison
+    PyObject *offset = PyDict_GetItem(index->names, name);
+    if(offset)
+        ret = V->getSubField(V->getFieldOffset() + PyLong_AsSize_t(offset));
+    return ret;
+}
+
+pvd::PVFieldPtr Value::lookup(PyObject *name)
+{
+    pvd::PVFieldPtr ret(lookup_fast(name));
+    if(!ret) {
+        // eg. bytes key with py3, or no such field
+        PyString S(name);
+        ret = V->getSubField(S.str());
+    }
+    return ret;
+}
+
 // so far not needed...
 //pvd::ScalarType ptype(NPY_TYPES t) {
 //    for(const npmap *p = np2pvd; p->npy!=NPY_NOTYPE; p++) {
@@ -111,20 +708,31 @@ void Value::store_struct(pvd::PVStructure* fld,
                          const pvd::BitSet::shared_pointer& bset)
 {
     if(PyDict_Check(obj)) {
+        // keys are resolved once for each Structure and set of keys.
+        // keep a ref. as storefld() may re-enter and replace plans.
+        std::tr1::shared_ptr<AssignPlan> plan(FieldIndex::lookup(*fld)->plan(*fld, obj));
+        const size_t base = fld->getFieldOffset();
+
         Py_ssize_t n=0;
         PyObject *K, *V;
-        while(PyDict_Next(obj, &n, &K, &V)) {
-            PyString key(K);
-            pvd::PVFieldPtr F(fld->getSubField(key.str()));
-            if(!F) {
-                PyErr_Format(PyExc_KeyError, "no sub-field %s.%s", fld->getFullName().c_str(), key.str().c_str());
+        for(size_t i=0; PyDict_Next(obj, &n, &K, &V); i++) {
+            if(i>=plan->entries.size()) {
+                PyErr_SetString(PyExc_RuntimeError, "dict changed size during assignment");
                 throw std::runtime_error("not seen");
             }
-            storefld(F.get(), F->getField().get(), V, bset);
+            const AssignPlan::Entry& ent = plan->entries[i];
+            pvd::PVFieldPtr F(fld->getSubField(base + ent.rel));
+
+            if(ent.store && ent.store(F.get(), V)) {
+                if(bset)
+                    bset->set(base + ent.rel);
+            } else {
+                storefld(F.get(), F->getField().get(), V, bset);
+            }
         }
 
     } else if(PyObject_IsInstance(obj, (PyObject*)P4PValue_type)) {
-        Value& W = P4PValue::unwrap(obj);
+        Value& W = P4PValue::unwrap(obj).sync();
         pvd::BitSet changed;
         if(W.I)
             changed = *W.I;
@@ -150,20 +758,13 @@ void Value::store_struct(pvd::PVStructure* fld,
             if(C.empty())
                 PyErr_WarnEx(PyExc_UserWarning, "enum_t assignment with empty choices", 2);
 
-            bool found = false;
-
-            // search for matching choices string
-            for(size_t i=0; i<C.size(); i++) {
-                if(C[i]==str) {
-                    // match
-                    index->putFrom<pvd::int32>(i);
-                    found = true;
-                    break;
-                }
-            }
+            size_t i;
+            if(ChoiceIndex::find(C, str, &i)) {
+                // match
+                index->putFrom<pvd::int32>(i);
 
-            // attempt to convert from string
-            if(!found) {
+            } else {
+                // attempt to convert from string
                 try {
                     index->putFrom(str);
                 } catch(std::runtime_error& e) {
@@ -593,7 +1194,13 @@ void Value::storefld(pvd::PVField* fld,
         const pvd::ScalarArray *T = static_cast<const pvd::ScalarArray *>(ftype);
         pvd::ScalarType etype = T->getElementType();
 
-        if(etype==pvd::pvString) {
+        if(etype==pvd::pvString && PyObject_TypeCheck(obj, P4PStringArray_type)) {
+            // storage is immutable, so share
+            static_cast<pvd::PVStringArray*>(F)->replace(P4PStringArray_extract(obj));
+            if(bset)
+                bset->set(fld_offset);
+
+        } else if(etype==pvd::pvString) {
             PyRef iter(PyObject_GetIter(obj));
 
             pvd::shared_vector<std::string> vec;
@@ -622,20 +1229,25 @@ void Value::storefld(pvd::PVField* fld,
         } else {
             NPY_TYPES nptype(ntype(etype));
 
-            PyRef V(PyArray_FromAny(obj, PyArray_DescrFromType(nptype), 0, 0,
-                                    NPY_CARRAY_RO, NULL));
+            // Storage of a read-only array is referenced, not copied.
+            // A numpy array can't reference a Value, so no cycle is possible.
+            pvd::shared_vector<const void> shared;
+
+            if(shareNumpy(obj, etype, nptype, shared)) {
+                F->putFrom(shared);
+            } else {
+                PyRef V(PyArray_FromAny(obj, PyArray_DescrFromType(nptype), 0, 0,
+                                        NPY_CARRAY_RO, NULL));
 
-            if(PyArray_NDIM(V.get())!=1)
-                throw std::runtime_error("Only 1-d array can be assigned");
+                if(PyArray_NDIM(V.get())!=1)
+                    throw std::runtime_error("Only 1-d array can be assigned");
 
-            // TODO: detect reference cycles so we can avoid this copy
-            //       Cycles can be created only if we both store and fetch
-            //       by reference.
-            pvd::shared_vector<void> buf(pvd::ScalarTypeFunc::allocArray(etype, PyArray_DIM(V.get(), 0)));
+                pvd::shared_vector<void> buf(pvd::ScalarTypeFunc::allocArray(etype, PyArray_DIM(V.get(), 0)));
 
-            memcpy(buf.data(), PyArray_DATA(V.get()), PyArray_NBYTES(V.get()));
+                memcpy(buf.data(), PyArray_DATA(V.get()), PyArray_NBYTES(V.get()));
 
-            F->putFrom(pvd::freeze(buf));
+                F->putFrom(pvd::freeze(buf));
+            }
             if(bset)
                 bset->set(fld_offset);
         }
@@ -718,7 +1330,8 @@ PyObject *Value::fetchfld(pvd::PVField *fld,
                           const pvd::BitSet::shared_pointer& bset,
                           bool unpackstruct,
                           bool unpackrecurse,
-                          PyObject *wrapper)
+                          PyObject *wrapper,
+                          bool lazy)
 {
     switch(ftype->getType()) {
     case pvd::scalar: {
@@ -759,6 +1372,11 @@ PyObject *Value::fetchfld(pvd::PVField *fld,
         if(etype==pvd::pvString) {
             pvd::shared_vector<const std::string> arr(static_cast<pvd::PVStringArray*>(F)->view());
 
+            if(lazy) {
+                // decode elements on demand
+                return P4PStringArray_make(arr);
+            }
+
             PyRef list(PyList_New(arr.size()));
 
             for(size_t i=0; i<arr.size(); i++) {
@@ -789,33 +1407,33 @@ PyObject *Value::fetchfld(pvd::PVField *fld,
         break;
     case pvd::structure: {
         pvd::PVStructure* F = static_cast<pvd::PVStructure*>(fld);
-        const pvd::Structure *T = static_cast<const pvd::Structure*>(ftype);
 
         if(unpackstruct) {
-            const pvd::StringArray& names(T->getFieldNames());
-            const pvd::FieldConstPtrArray& flds(T->getFields());
-            const pvd::PVFieldPtrArray& vals(F->getPVFields());
-
-            PyRef list(PyList_New(vals.size()));
-
-            for(size_t i=0; i<vals.size(); i++) {
-                PyRef val(fetchfld(vals[i].get(), flds[i].get(), bset, unpackrecurse, true, wrapper));
-
-                PyRef item(Py_BuildValue("sO", names[i].c_str(), val.get()));
-
-                PyList_SET_ITEM(list.get(), i, item.release());
-            }
-
-            if (wrapper) {
-                PyRef dict(PyObject_CallFunction(wrapper, "O", list.get()));
-                return dict.release();
-            }
-
-            return list.release();
+            return fetch_struct(F, bset, unpackrecurse, wrapper, 0);
 
         } else {
             PyObject *self = P4PValue::wrap(this);
-            return P4PValue_wrap(Py_TYPE(self), std::tr1::static_pointer_cast<pvd::PVStructure>(F->shared_from_this()), bset);
+            pvd::PVStructurePtr S(std::tr1::static_pointer_cast<pvd::PVStructure>(F->shared_from_this()));
+
+            const pvd::PVStructure *stop = S.get();
+            while(stop->getParent())
+                stop = stop->getParent();
+
+            if(root && stop==root->root.get()) {
+                // a sub-structure of our storage, which the new Value shares
+                PyRef ret(P4PValue_wrap(Py_TYPE(self), S, bset));
+                Value& sub = P4PValue::unwrap(ret.get());
+                sub.root = root;
+                sub.top = top;
+                return ret.release();
+
+            } else if(root && root->shared) {
+                // element of a structure array or union, which isn't ours to modify
+                pvd::PVStructurePtr copy(pvd::getPVDataCreate()->createPVStructure(S->getStructure()));
+                copy->copyUnchecked(*S);
+                S = copy;
+            }
+            return P4PValue_wrap(Py_TYPE(self), S, bset);
 
         }
     }
@@ -884,79 +1502,540 @@ PyObject *Value::fetchfld(pvd::PVField *fld,
     throw std::runtime_error("map for read not implemented");
 }
 
-int P4PValue_init(PyObject *self, PyObject *args, PyObject *kwds)
+PyObject *Value::fetch_struct(pvd::PVStructure *fld,
+                              const pvd::BitSet::shared_pointer& bset,
+                              bool unpackrecurse,
+                              PyObject* wrapper,
+                              const pvd::BitSet *mask)
 {
-    TRY {
-        const char *names[] = {"type", "value", "clone", NULL};
-        PyObject *type = NULL, *value = Py_None;
-        PyObject *clone = NULL;
-        if(!PyArg_ParseTupleAndKeywords(args, kwds, "|OOO!", (char**)names,
-                                        &type,
-                                        &value,
-                                        P4PValue_type, &clone))
-            return -1;
+    // interned keys, shared by all instances of this Structure
+    std::tr1::shared_ptr<FieldIndex> idx(FieldIndex::lookup(*fld));
 
-        if(SELF.V) {
-            // magic construction w/ P4PValue_wrap()
+    const pvd::FieldConstPtrArray& flds(fld->getStructure()->getFields());
+    const pvd::PVFieldPtrArray& vals(fld->getPVFields());
 
-        } else if(type) {
-            pvd::Structure::const_shared_pointer S(P4PType_unwrap(type));
+    // skip the intermediate list of tuples in the common case
+    bool direct = wrapper==(PyObject*)&PyDict_Type;
 
-            pvd::PVStructure::shared_pointer V(pvd::getPVDataCreate()->createPVStructure(S));
+    PyRef ret(direct ? PyDict_New() : PyList_New(0));
 
-            SELF.I.reset(new pvd::BitSet(V->getNextFieldOffset()));
+    for(size_t i=0; i<vals.size(); i++) {
+        pvd::PVField *sub = vals[i].get();
+        const pvd::BitSet *submask = mask;
 
-            if(value!=Py_None) {
-                SELF.store_struct(V.get(), S.get(), value, SELF.I);
+        if(mask) {
+            size_t b0 = sub->getFieldOffset(),
+                   b1 = sub->getNextFieldOffset();
+            if(mask->get(b0)) {
+                submask = 0; // entire sub-field is included
+            } else {
+                pvd::int32 next = mask->nextSetBit(b0);
+                if(next<0 || size_t(next)>=b1)
+                    continue;
             }
+        }
 
-            SELF.V = V;
+        PyRef val;
+        if(unpackrecurse && flds[i]->getType()==pvd::structure)
+            val.reset(fetch_struct(static_cast<pvd::PVStructure*>(sub), bset, true, wrapper, submask));
+        else
+            val.reset(fetchfld(sub, flds[i].get(), bset, unpackrecurse, true, wrapper));
 
-        } else if(clone) {
-            const P4PValue::reference_type other = P4PValue::unwrap(clone);
-            SELF.V = other.V;
-            SELF.I.reset(new pvd::BitSet);
-            *SELF.I = *other.I;
+        PyObject *key = PyTuple_GET_ITEM(idx->keys, i);
+
+        if(direct) {
+            if(PyDict_SetItem(ret.get(), key, val.get()))
+                throw std::runtime_error("XXX");
 
         } else {
-            PyErr_SetString(PyExc_ValueError, "Value ctor requires type= or clone=");
-            return -1;
+            PyRef item(PyTuple_Pack(2, key, val.get()));
+            if(PyList_Append(ret.get(), item.get()))
+                throw std::runtime_error("XXX");
         }
+    }
 
-        return 0;
-    }CATCH()
-    return -1;
+    if(wrapper && !direct) {
+        PyRef dict(PyObject_CallFunction(wrapper, "O", ret.get()));
+        return dict.release();
+    }
+
+    return ret.release();
 }
 
-int P4PValue_setattr(PyObject *self, PyObject *name, PyObject *value)
+// Compare 'dest' with 'other', setting 'changed' for each leaf field of 'dest' which differs.
+// If 'assign', also copy the differing values from 'other' into 'dest'.
+// Both must have the same type.  Returns true if any field differs.
+bool diff_field(pvd::PVField& dest, const pvd::PVField& other, pvd::BitSet& changed, bool assign)
 {
-    TRY {
-        PyString S(name);
-        pvd::PVFieldPtr fld = SELF.V->getSubField(S.str());
-        if(!fld)
-            return PyObject_GenericSetAttr((PyObject*)self, name, value);
-
-        SELF.storefld(fld.get(),
-                       fld->getField().get(),
-                       value,
-                       SELF.I);
+    bool differ;
 
-        return 0;
-    }CATCH()
-    return -1;
+    switch(dest.getField()->getType()) {
+    case pvd::structure: {
+        const pvd::PVFieldPtrArray& D(static_cast<pvd::PVStructure&>(dest).getPVFields());
+        const pvd::PVFieldPtrArray& O(static_cast<const pvd::PVStructure&>(other).getPVFields());
+        bool any = false;
+        for(size_t i=0; i<D.size(); i++)
+            any |= diff_field(*D[i], *O[i], changed, assign);
+        return any;
+    }
+    case pvd::scalarArray: {
+        const pvd::PVScalarArray& D(static_cast<const pvd::PVScalarArray&>(dest));
+        const pvd::PVScalarArray& O(static_cast<const pvd::PVScalarArray&>(other));
+
+        if(D.getScalarArray()->getElementType()==pvd::pvString) {
+            pvd::PVStringArray::const_svector DV(static_cast<const pvd::PVStringArray&>(D).view()),
+                                              OV(static_cast<const pvd::PVStringArray&>(O).view());
+            differ = DV.size()!=OV.size()
+                    || (DV.data()!=OV.data() && !std::equal(DV.begin(), DV.end(), OV.begin()));
+        } else {
+            pvd::shared_vector<const void> DV, OV;
+            D.getAs(DV);
+            O.getAs(OV);
+            // identical storage is common when a Value is re-posted
+            differ = DV.size()!=OV.size()
+                    || (DV.data()!=OV.data() && memcmp(DV.data(), OV.data(), DV.size())!=0);
+        }
+    }
+        break;
+    default:
+        // scalars, unions, and arrays of structure/union are compared as a whole
+        differ = !(dest==other);
+        break;
+    }
 
+    if(differ) {
+        changed.set(dest.getFieldOffset());
+        if(assign)
+            dest.copyUnchecked(other);
+    }
+    return differ;
 }
 
-PyObject* P4PValue_getattr(PyObject *self, PyObject *name)
-{
-    TRY {
-        PyObject *ret = PyObject_GenericGetAttr((PyObject*)self, name);
-        if(ret)
+struct ValueSerial : public pvd::Serializable {
+    pvd::PVStructurePtr V;
+    // changed mask, or only bit 0 when not tracking.
+    // Offsets relative to V, which is deserialized as a top-level structure.
+    mutable pvd::BitSet changed;
+    // 'changed' at the offsets of V within its top-level structure.  Used to serialize a delta
+    mutable pvd::BitSet written;
+    bool delta;
+
+    ValueSerial() :delta(false) {}
+    virtual ~ValueSerial() {}
+
+    virtual void serialize(pvd::ByteBuffer *buf, pvd::SerializableControl *ctrl) const OVERRIDE FINAL
+    {
+        ctrl->cachedSerialize(V->getStructure(), buf);
+        ctrl->ensureBuffer(1);
+        buf->putByte(delta ? 1 : 0);
+        changed.serialize(buf, ctrl);
+        if(delta)
+            V->serialize(buf, ctrl, &written);
+        else
+            V->serialize(buf, ctrl);
+    }
+
+    virtual void deserialize(pvd::ByteBuffer *buf, pvd::DeserializableControl *ctrl) OVERRIDE FINAL
+    {
+        pvd::FieldConstPtr type(ctrl->cachedDeserialize(buf));
+        if(!type || type->getType()!=pvd::structure)
+            throw std::runtime_error("Serialized type is not a structure");
+
+        V = pvd::getPVDataCreate()->createPVStructure(std::tr1::static_pointer_cast<const pvd::Structure>(type));
+
+        ctrl->ensureData(1);
+        delta = buf->getByte()!=0;
+        changed.deserialize(buf, ctrl);
+        if(delta)
+            V->deserialize(buf, ctrl, &changed);
+        else
+            V->deserialize(buf, ctrl);
+    }
+};
+
+// Table-like fields are either a structure of scalar arrays (eg. NTTable.value),
+// or an array of structures of scalars.  Either is converted to/from a dict
+// of column arrays, or a numpy structured array.
+
+template<typename T>
+void fetch_column(void *out, const pvd::PVStructureArray::const_svector& arr, size_t col)
+{
+    T *dest = (T*)out;
+    for(size_t i=0, N=arr.size(); i<N; i++) {
+        dest[i] = arr[i] ? static_cast<const pvd::PVScalarValue<T>*>(arr[i]->getPVFields()[col].get())->get() : T();
+    }
+}
+
+template<typename T>
+void store_column(const void *in, pvd::PVStructureArray::svector& arr, size_t col)
+{
+    const T *src = (const T*)in;
+    for(size_t i=0, N=arr.size(); i<N; i++) {
+        static_cast<pvd::PVScalarValue<T>*>(arr[i]->getPVFields()[col].get())->put(src[i]);
+    }
+}
+
+#define COLUMN_SWITCH(ETYPE, FN, ARGS) \
+    switch(ETYPE) { \
+    case pvd::pvBoolean: FN<pvd::boolean> ARGS; break; \
+    case pvd::pvByte:    FN<pvd::int8> ARGS; break; \
+    case pvd::pvShort:   FN<pvd::int16> ARGS; break; \
+    case pvd::pvInt:     FN<pvd::int32> ARGS; break; \
+    case pvd::pvLong:    FN<pvd::int64> ARGS; break; \
+    case pvd::pvUByte:   FN<pvd::uint8> ARGS; break; \
+    case pvd::pvUShort:  FN<pvd::uint16> ARGS; break; \
+    case pvd::pvUInt:    FN<pvd::uint32> ARGS; break; \
+    case pvd::pvULong:   FN<pvd::uint64> ARGS; break; \
+    case pvd::pvFloat:   FN<float> ARGS; break; \
+    case pvd::pvDouble:  FN<double> ARGS; break; \
+    default: throw std::logic_error("Unexpected column type"); \
+    }
+
+// element types of the columns of a table-like structure
+void table_columns(const pvd::Structure *T, bool arrays, std::vector<pvd::ScalarType>& etypes)
+{
+    const pvd::FieldConstPtrArray& flds(T->getFields());
+    const pvd::StringArray& names(T->getFieldNames());
+    etypes.resize(flds.size());
+
+    for(size_t i=0; i<flds.size(); i++) {
+        if(arrays && flds[i]->getType()==pvd::scalarArray) {
+            etypes[i] = static_cast<const pvd::ScalarArray*>(flds[i].get())->getElementType();
+        } else if(!arrays && flds[i]->getType()==pvd::scalar) {
+            etypes[i] = static_cast<const pvd::Scalar*>(flds[i].get())->getScalarType();
+        } else {
+            PyErr_Format(PyExc_ValueError, "Field %s is not a %s", names[i].c_str(),
+                         arrays ? "scalar array" : "scalar");
+            throw std::runtime_error("not seen");
+        }
+    }
+}
+
+// Combine columns into a numpy structured array
+PyObject* columns_to_structured(const pvd::StringArray& names,
+                                const std::vector<pvd::ScalarType>& etypes,
+                                const std::vector<PyRef>& cols,
+                                npy_intp nrows)
+{
+    PyRef spec(PyList_New(names.size()));
+    for(size_t i=0; i<names.size(); i++) {
+        PyRef dtype((PyObject*)PyArray_DescrFromType(etypes[i]==pvd::pvString ? NPY_OBJECT : ntype(etypes[i])));
+        PyList_SET_ITEM(spec.get(), i, Py_BuildValue("sO", names[i].c_str(), dtype.get()));
+        if(!PyList_GET_ITEM(spec.get(), i))
+            throw std::runtime_error("XXX");
+    }
+
+    PyArray_Descr *descr = 0;
+    if(!PyArray_DescrConverter(spec.get(), &descr))
+        throw std::runtime_error("XXX");
+
+    PyRef ret(PyArray_Zeros(1, &nrows, descr, 0)); // steals descr
+
+    for(size_t i=0; i<names.size(); i++) {
+        if(PyMapping_SetItemString(ret.get(), (char*)names[i].c_str(), cols[i].get()))
+            throw std::runtime_error("XXX");
+    }
+
+    return ret.release();
+}
+
+// Lookup one column from a dict, or numpy structured array.
+// Returns NULL if not present.
+PyObject* get_column(PyObject *obj, const std::string& name)
+{
+    if(PyArray_Check(obj)) {
+        PyObject *fields = PyArray_DESCR((PyArrayObject*)obj)->fields;
+        if(!fields || !PyDict_Check(fields) || !PyDict_GetItemString(fields, name.c_str()))
+            return NULL;
+    } else if(!PyMapping_HasKeyString(obj, (char*)name.c_str())) {
+        return NULL;
+    }
+    PyObject *ret = PyMapping_GetItemString(obj, (char*)name.c_str());
+    if(!ret)
+        throw std::runtime_error("XXX");
+    return ret;
+}
+
+PyObject *Value::fetch_columns(pvd::PVField *fld, bool structured)
+{
+    pvd::BitSet::shared_pointer empty;
+    const pvd::StringArray *names;
+    std::vector<pvd::ScalarType> etypes;
+    std::vector<PyRef> cols;
+    npy_intp nrows = 0;
+
+    if(fld->getField()->getType()==pvd::structure) {
+        pvd::PVStructure *F = static_cast<pvd::PVStructure*>(fld);
+        const pvd::PVFieldPtrArray& vals(F->getPVFields());
+        names = &F->getStructure()->getFieldNames();
+        table_columns(F->getStructure().get(), true, etypes);
+        cols.resize(vals.size());
+
+        for(size_t i=0; i<vals.size(); i++) {
+            npy_intp len = static_cast<pvd::PVScalarArray*>(vals[i].get())->getLength();
+            if(i==0) {
+                nrows = len;
+            } else if(structured && len!=nrows) {
+                PyErr_Format(PyExc_ValueError, "Column %s length %lu != %lu", (*names)[i].c_str(),
+                             (unsigned long)len, (unsigned long)nrows);
+                throw std::runtime_error("not seen");
+            }
+            // numeric columns reference the existing arrays.  string columns are lists
+            cols[i].reset(fetchfld(vals[i].get(), vals[i]->getField().get(), empty, true));
+        }
+
+    } else if(fld->getField()->getType()==pvd::structureArray) {
+        pvd::PVStructureArray *F = static_cast<pvd::PVStructureArray*>(fld);
+        const pvd::Structure *ST = F->getStructureArray()->getStructure().get();
+        pvd::PVStructureArray::const_svector arr(F->view());
+        names = &ST->getFieldNames();
+        table_columns(ST, false, etypes);
+        cols.resize(etypes.size());
+        nrows = arr.size();
+
+        for(size_t c=0; c<etypes.size(); c++) {
+            if(etypes[c]==pvd::pvString) {
+                PyRef list(PyList_New(nrows));
+                for(npy_intp i=0; i<nrows; i++) {
+                    PyObject *S = PyUnicode_FromString(arr[i] ? static_cast<const pvd::PVString*>(arr[i]->getPVFields()[c].get())->get().c_str() : "");
+                    if(!S)
+                        throw std::runtime_error("XXX");
+                    PyList_SET_ITEM(list.get(), i, S);
+                }
+                cols[c].swap(list);
+
+            } else {
+                PyRef col(PyArray_SimpleNew(1, &nrows, ntype(etypes[c])));
+                COLUMN_SWITCH(etypes[c], fetch_column, (PyArray_DATA((PyArrayObject*)col.get()), arr, c));
+                cols[c].swap(col);
+            }
+        }
+
+    } else {
+        throw std::runtime_error(SB()<<fld->getFullName()<<" is not a structure or structure array");
+    }
+
+    if(structured)
+        return columns_to_structured(*names, etypes, cols, nrows);
+
+    PyRef ret(PyDict_New());
+    for(size_t i=0; i<cols.size(); i++) {
+        if(PyDict_SetItemString(ret.get(), (*names)[i].c_str(), cols[i].get()))
+            throw std::runtime_error("XXX");
+    }
+    return ret.release();
+}
+
+void Value::store_columns(pvd::PVField *fld,
+                          PyObject *obj,
+                          const pvd::BitSet::shared_pointer& bset)
+{
+    const pvd::Structure *ST;
+    bool arrays = fld->getField()->getType()==pvd::structure;
+
+    if(arrays)
+        ST = static_cast<pvd::PVStructure*>(fld)->getStructure().get();
+    else if(fld->getField()->getType()==pvd::structureArray)
+        ST = static_cast<pvd::PVStructureArray*>(fld)->getStructureArray()->getStructure().get();
+    else
+        throw std::runtime_error(SB()<<fld->getFullName()<<" is not a structure or structure array");
+
+    std::vector<pvd::ScalarType> etypes;
+    table_columns(ST, arrays, etypes);
+    const pvd::StringArray& names(ST->getFieldNames());
+
+    // reject unknown columns
+    {
+        PyRef keys;
+        if(PyArray_Check(obj)) {
+            PyObject *N = PyArray_DESCR((PyArrayObject*)obj)->names;
+            if(!N || N==Py_None || PyArray_NDIM((PyArrayObject*)obj)!=1)
+                throw std::runtime_error("Only a 1-d numpy structured array can be assigned");
+            keys.reset(N, borrow());
+        } else {
+            keys.reset(PyMapping_Keys(obj));
+        }
+
+        PyRef iter(PyObject_GetIter(keys.get()));
+        while(true) {
+            PyRef K(PyIter_Next(iter.get()), nextiter());
+            if(!K) break;
+
+            PyString key(K.get());
+            if(!ST->getField(key.str())) {
+                PyErr_Format(PyExc_KeyError, "no column %s.%s", fld->getFullName().c_str(), key.str().c_str());
+                throw std::runtime_error("not seen");
+            }
+        }
+    }
+
+    if(arrays) {
+        // each column is assigned as an array, which will be referenced when possible.
+        pvd::PVStructure *F = static_cast<pvd::PVStructure*>(fld);
+        const pvd::PVFieldPtrArray& vals(F->getPVFields());
+
+        for(size_t i=0; i<vals.size(); i++) {
+            PyRef col(get_column(obj, names[i]), allownull());
+            if(col)
+                storefld(vals[i].get(), vals[i]->getField().get(), col.get(), bset);
+        }
+
+    } else {
+        pvd::PVStructureArray *F = static_cast<pvd::PVStructureArray*>(fld);
+        const pvd::PVDataCreatePtr& create = pvd::getPVDataCreate();
+        pvd::StructureConstPtr elemtype(F->getStructureArray()->getStructure());
+
+        std::vector<PyRef> cols(etypes.size());
+        Py_ssize_t nrows = -1;
+
+        if(PyArray_Check(obj))
+            nrows = PyArray_DIM((PyArrayObject*)obj, 0);
+
+        for(size_t c=0; c<etypes.size(); c++) {
+            cols[c].reset(get_column(obj, names[c]));
+            if(!cols[c]) continue;
+
+            Py_ssize_t len = PyObject_Length(cols[c].get());
+            if(len<0)
+                throw std::runtime_error("XXX");
+            else if(nrows==-1)
+                nrows = len;
+            else if(len!=nrows) {
+                PyErr_Format(PyExc_ValueError, "Column %s length %lu != %lu", names[c].c_str(),
+                             (unsigned long)len, (unsigned long)nrows);
+                throw std::runtime_error("not seen");
+            }
+        }
+        if(nrows==-1)
+            nrows = 0;
+
+        pvd::PVStructureArray::svector arr(nrows);
+        for(Py_ssize_t i=0; i<nrows; i++)
+            arr[i] = create->createPVStructure(elemtype);
+
+        for(size_t c=0; c<etypes.size(); c++) {
+            if(!cols[c]) continue;
+
+            if(etypes[c]==pvd::pvString) {
+                PyRef iter(PyObject_GetIter(cols[c].get()));
+                for(Py_ssize_t i=0; i<nrows; i++) {
+                    PyRef I(PyIter_Next(iter.get()), nextiter());
+                    if(!I) break;
+                    PyString S(I.get());
+                    static_cast<pvd::PVString*>(arr[i]->getPVFields()[c].get())->put(S.str());
+                }
+
+            } else {
+                // numpy converts, and makes contiguous, with a vectorized copy
+                PyRef V(PyArray_FromAny(cols[c].get(), PyArray_DescrFromType(ntype(etypes[c])), 1, 1,
+                                        NPY_CARRAY_RO, NULL));
+                COLUMN_SWITCH(etypes[c], store_column, (PyArray_DATA((PyArrayObject*)V.get()), arr, c));
+            }
+        }
+
+        F->replace(pvd::freeze(arr));
+        if(bset)
+            bset->set(fld->getFieldOffset());
+    }
+}
+
+#undef COLUMN_SWITCH
+
+int P4PValue_init(PyObject *self, PyObject *args, PyObject *kwds)
+{
+    TRY {
+        const char *names[] = {"type", "value", "clone", NULL};
+        PyObject *type = NULL, *value = Py_None;
+        PyObject *clone = NULL;
+        if(!PyArg_ParseTupleAndKeywords(args, kwds, "|OOO!", (char**)names,
+                                        &type,
+                                        &value,
+                                        P4PValue_type, &clone))
+            return -1;
+
+        if(SELF.V) {
+            // magic construction w/ P4PValue_wrap()
+
+        } else if(type) {
+            pvd::Structure::const_shared_pointer S(P4PType_unwrap(type));
+
+            pvd::PVStructure::shared_pointer V(pvd::getPVDataCreate()->createPVStructure(S));
+
+            SELF.I.reset(new pvd::BitSet(V->getNextFieldOffset()));
+
+            if(value!=Py_None) {
+                SELF.store_struct(V.get(), S.get(), value, SELF.I);
+            }
+
+            SELF.V = V;
+            SELF.root.reset(new P4PValueRoot(V));
+            SELF.top = V.get();
+
+        } else if(clone) {
+            Value& other = P4PValue::unwrap(clone).sync();
+
+            if(other.V->getParent()) {
+                // clone of a sub-structure is a copy
+                pvd::PVStructurePtr V(pvd::getPVDataCreate()->createPVStructure(other.V->getStructure()));
+                V->copyUnchecked(*other.V);
+                SELF.V = V;
+                SELF.root.reset(new P4PValueRoot(V));
+
+            } else {
+                // share storage until either is modified
+                if(other.root->lent) {
+                    other.root->detach();
+                    other.sync();
+                }
+                other.root->shared = true;
+                SELF.V = other.V;
+                SELF.root.reset(new P4PValueRoot(other.V, true));
+            }
+            SELF.top = SELF.V.get();
+
+            SELF.I.reset(new pvd::BitSet);
+            if(other.I)
+                *SELF.I = *other.I;
+
+        } else {
+            PyErr_SetString(PyExc_ValueError, "Value ctor requires type= or clone=");
+            return -1;
+        }
+
+        return 0;
+    }CATCH()
+    return -1;
+}
+
+int P4PValue_setattr(PyObject *self, PyObject *name, PyObject *value)
+{
+    TRY {
+        SELF.writable();
+
+        pvd::PVFieldPtr fld = SELF.lookup(name);
+        if(!fld)
+            return PyObject_GenericSetAttr((PyObject*)self, name, value);
+
+        SELF.storefld(fld.get(),
+                       fld->getField().get(),
+                       value,
+                       SELF.I);
+
+        return 0;
+    }CATCH()
+    return -1;
+
+}
+
+PyObject* P4PValue_getattr(PyObject *self, PyObject *name)
+{
+    TRY {
+        PyObject *ret = PyObject_GenericGetAttr((PyObject*)self, name);
+        if(ret)
             return ret;
         // there is an AttributeError
 
-        PyString S(name);
-        pvd::PVFieldPtr fld = SELF.V->getSubField(S.str());
+        pvd::PVFieldPtr fld(SELF.lookup(name));
         if(!fld)
             return 0;
         PyErr_Clear(); // clear AttributeError
@@ -970,12 +2049,26 @@ PyObject* P4PValue_getattr(PyObject *self, PyObject *name)
     return NULL;
 }
 
+// mask for todict(changed_only=True).  NULL to include all sub-fields of 'fld'
+const pvd::BitSet* changedMask(const Value& SELF, const pvd::PVField *fld, PyObject *changed_only)
+{
+    if(!SELF.I || !PyObject_IsTrue(changed_only))
+        return 0;
+    // a marked parent implies all sub-fields
+    for(const pvd::PVField *cur = fld; cur; cur = cur->getParent()) {
+        if(SELF.I->get(cur->getFieldOffset()))
+            return 0;
+    }
+    return SELF.I.get();
+}
+
 PyObject* P4PValue_toList(PyObject *self, PyObject *args, PyObject *kws)
 {
     TRY {
-        const char *names[] = {"name", NULL};
+        const char *names[] = {"name", "changed_only", NULL};
         const char *name = NULL;
-        if(!PyArg_ParseTupleAndKeywords(args, kws, "|z", (char**)names, &name))
+        PyObject *changed_only = Py_False;
+        if(!PyArg_ParseTupleAndKeywords(args, kws, "|zO", (char**)names, &name, &changed_only))
             return NULL;
 
         pvd::PVFieldPtr fld;
@@ -989,6 +2082,12 @@ PyObject* P4PValue_toList(PyObject *self, PyObject *args, PyObject *kws)
             return NULL;
         }
 
+        if(fld->getField()->getType()==pvd::structure) {
+            return SELF.fetch_struct(static_cast<pvd::PVStructure*>(fld.get()),
+                                     SELF.I, true, 0,
+                                     changedMask(SELF, fld.get(), changed_only));
+        }
+
         // return sub-struct as list of tuple
         return SELF.fetchfld(fld.get(),
                              fld->getField().get(),
@@ -1002,10 +2101,11 @@ PyObject* P4PValue_toList(PyObject *self, PyObject *args, PyObject *kws)
 PyObject* P4PValue_toDict(PyObject *self, PyObject *args, PyObject *kws)
 {
     TRY {
-        const char *names[] = {"name", "type", NULL};
+        const char *names[] = {"name", "type", "changed_only", NULL};
         const char *name = NULL;
         PyObject *wrapper = (PyObject*)&PyDict_Type;
-        if(!PyArg_ParseTupleAndKeywords(args, kws, "|zO!", (char**)names, &name, &PyType_Type, &wrapper))
+        PyObject *changed_only = Py_False;
+        if(!PyArg_ParseTupleAndKeywords(args, kws, "|zO!O", (char**)names, &name, &PyType_Type, &wrapper, &changed_only))
             return NULL;
 
         pvd::PVFieldPtr fld;
@@ -1019,7 +2119,12 @@ PyObject* P4PValue_toDict(PyObject *self, PyObject *args, PyObject *kws)
             return NULL;
         }
 
-        // return sub-struct as list of tuple
+        if(fld->getField()->getType()==pvd::structure) {
+            return SELF.fetch_struct(static_cast<pvd::PVStructure*>(fld.get()),
+                                     SELF.I, true, wrapper,
+                                     changedMask(SELF, fld.get(), changed_only));
+        }
+
         return SELF.fetchfld(fld.get(),
                              fld->getField().get(),
                              SELF.I,
@@ -1032,6 +2137,62 @@ PyObject* P4PValue_toDict(PyObject *self, PyObject *args, PyObject *kws)
 }
 
 
+PyObject* P4PValue_toColumns(PyObject *self, PyObject *args, PyObject *kws)
+{
+    TRY {
+        const char *names[] = {"name", "structured", NULL};
+        const char *name = NULL;
+        PyObject *structured = Py_False;
+        if(!PyArg_ParseTupleAndKeywords(args, kws, "|zO", (char**)names, &name, &structured))
+            return NULL;
+
+        pvd::PVFieldPtr fld;
+        if(name)
+            fld = SELF.V->getSubField(name);
+        else
+            fld = SELF.V;
+
+        if(!fld) {
+            PyErr_SetString(PyExc_KeyError, name ? name : "<null>");
+            return NULL;
+        }
+
+        return SELF.fetch_columns(fld.get(), PyObject_IsTrue(structured));
+
+    }CATCH()
+    return NULL;
+}
+
+PyObject* P4PValue_fromColumns(PyObject *self, PyObject *args, PyObject *kws)
+{
+    TRY {
+        const char *names[] = {"value", "name", NULL};
+        PyObject *value;
+        const char *name = NULL;
+        if(!PyArg_ParseTupleAndKeywords(args, kws, "O|z", (char**)names, &value, &name))
+            return NULL;
+
+        SELF.writable();
+
+        pvd::PVFieldPtr fld;
+        if(name)
+            fld = SELF.V->getSubField(name);
+        else
+            fld = SELF.V;
+
+        if(!fld) {
+            PyErr_SetString(PyExc_KeyError, name ? name : "<null>");
+            return NULL;
+        }
+
+        SELF.store_columns(fld.get(), value, SELF.I);
+
+        Py_RETURN_NONE;
+    }CATCH()
+    return NULL;
+}
+
+
 PyObject* P4PValue_items(PyObject *self, PyObject *args)
 {
     TRY {
@@ -1108,6 +2269,8 @@ PyObject *P4PValue_select(PyObject *self, PyObject *args, PyObject *kwds)
         if(!PyArg_ParseTupleAndKeywords(args, kwds, "sz", (char**)names, &name, &sel))
             return NULL;
 
+        SELF.writable();
+
         pvd::PVUnionPtr fld(SELF.V->getSubField<pvd::PVUnion>(name));
         if(!fld)
             return PyErr_Format(PyExc_KeyError, "%s", name);
@@ -1130,11 +2293,11 @@ PyObject *P4PValue_select(PyObject *self, PyObject *args, PyObject *kwds)
 PyObject *P4PValue_has(PyObject *self, PyObject *args)
 {
     TRY {
-        const char *name;
-        if(!PyArg_ParseTuple(args, "s", &name))
+        PyObject *name;
+        if(!PyArg_ParseTuple(args, "O", &name))
             return NULL;
 
-        if(SELF.V->getSubField(name))
+        if(SELF.lookup(name))
             Py_RETURN_TRUE;
         else
             Py_RETURN_FALSE;
@@ -1142,15 +2305,16 @@ PyObject *P4PValue_has(PyObject *self, PyObject *args)
     return NULL;
 }
 
-PyObject *P4PValue_get(PyObject *self, PyObject *args)
+PyObject *P4PValue_get(PyObject *self, PyObject *args, PyObject *kws)
 {
     TRY {
-        const char *name;
-        PyObject *defval = Py_None;
-        if(!PyArg_ParseTuple(args, "s|O", &name, &defval))
+        static const char* names[] = {"name", "default", "lazy", NULL};
+        PyObject *name;
+        PyObject *defval = Py_None, *pylazy = Py_False;
+        if(!PyArg_ParseTupleAndKeywords(args, kws, "O|OO", (char**)names, &name, &defval, &pylazy))
             return NULL;
 
-        pvd::PVFieldPtr fld = SELF.V->getSubField(name);
+        pvd::PVFieldPtr fld = SELF.lookup(name);
         if(!fld) {
             Py_INCREF(defval);
             return defval;
@@ -1160,7 +2324,8 @@ PyObject *P4PValue_get(PyObject *self, PyObject *args)
         return SELF.fetchfld(fld.get(),
                              fld->getField().get(),
                              SELF.I,
-                             false);
+                             false, true, 0,
+                             PyObject_IsTrue(pylazy));
     }CATCH()
     return NULL;
 }
@@ -1201,8 +2366,8 @@ PyObject *P4PValue_gettype(PyObject *self, PyObject *args)
 PyObject* P4PValue_changed(PyObject *self, PyObject *args, PyObject *kws)
 {
     static const char* names[] = {"field", NULL};
-    const char* fname = NULL;
-    if(!PyArg_ParseTupleAndKeywords(args, kws, "|z", (char**)names, &fname))
+    PyObject* fname = Py_None;
+    if(!PyArg_ParseTupleAndKeywords(args, kws, "|O", (char**)names, &fname))
         return NULL;
     TRY {
 
@@ -1210,12 +2375,14 @@ PyObject* P4PValue_changed(PyObject *self, PyObject *args, PyObject *kws)
             Py_RETURN_TRUE;
 
         pvd::PVField::shared_pointer fld;
-        if(fname)
-            fld = SELF.V->getSubField(fname);
+        if(fname!=Py_None)
+            fld = SELF.lookup(fname);
         else
             fld = SELF.V;
-        if(!fld)
-            return PyErr_Format(PyExc_KeyError, "%s", fname);
+        if(!fld) {
+            PyErr_SetObject(PyExc_KeyError, fname);
+            return NULL;
+        }
 
         // is the bit associated with this field set?
         const size_t offset = fld->getFieldOffset();
@@ -1283,6 +2450,163 @@ PyObject* P4PValue_unmark(PyObject *self)
     return NULL;
 }
 
+PyObject* P4PValue_tojson(PyObject *self, PyObject *args, PyObject *kws)
+{
+    static const char* names[] = {"changed_only", "nan", NULL};
+    PyObject *changed_only = Py_False;
+    const char *nan = "literal";
+    if(!PyArg_ParseTupleAndKeywords(args, kws, "|Os", (char**)names, &changed_only, &nan))
+        return NULL;
+    TRY {
+        P4PJSONNaN policy;
+        if(strcmp(nan, "literal")==0)
+            policy = P4PJSONNaNLiteral;
+        else if(strcmp(nan, "null")==0)
+            policy = P4PJSONNaNNull;
+        else if(strcmp(nan, "error")==0)
+            policy = P4PJSONNaNError;
+        else
+            return PyErr_Format(PyExc_ValueError, "nan= must be one of 'literal', 'null', or 'error'");
+
+        std::string out;
+        p4p_to_json(out, *SELF.V, PyObject_IsTrue(changed_only) ? SELF.I.get() : 0, policy);
+
+        return PyBytes_FromStringAndSize(out.c_str(), out.size());
+    }catch(std::invalid_argument& e){
+        PyErr_SetString(PyExc_ValueError, e.what());
+    }CATCH()
+    return NULL;
+}
+
+PyObject* P4PValue_fromjson(PyObject *self, PyObject *args, PyObject *kws)
+{
+    static const char* names[] = {"data", "strict", NULL};
+    PyObject *data, *strict = Py_True;
+    if(!PyArg_ParseTupleAndKeywords(args, kws, "O|O", (char**)names, &data, &strict))
+        return NULL;
+    TRY {
+        PyRef temp;
+        if(PyUnicode_Check(data)) {
+            temp.reset(PyUnicode_AsUTF8String(data));
+            data = temp.get();
+        } else if(!PyBytes_Check(data)) {
+            return PyErr_Format(PyExc_TypeError, "fromjson() expects bytes or str, not %s", Py_TYPE(data)->tp_name);
+        }
+
+        SELF.writable();
+
+        p4p_from_json(PyBytes_AS_STRING(data), PyBytes_GET_SIZE(data),
+                      *SELF.V, SELF.I.get(), PyObject_IsTrue(strict));
+
+        Py_RETURN_NONE;
+    }catch(std::invalid_argument& e){
+        PyErr_SetString(PyExc_ValueError, e.what());
+    }CATCH()
+    return NULL;
+}
+
+PyObject* P4PValue_diff(PyObject *self, PyObject *args, PyObject *kws)
+{
+    static const char* names[] = {"other", NULL};
+    PyObject *other;
+    if(!PyArg_ParseTupleAndKeywords(args, kws, "O!", (char**)names, &P4PValue::type, &other))
+        return NULL;
+    TRY {
+        const Value& O = P4PValue::unwrap(other).sync();
+
+        if(SELF.V->getStructure()!=O.V->getStructure() && *SELF.V->getStructure()!=*O.V->getStructure())
+            return PyErr_Format(PyExc_ValueError, "diff() requires Values of the same type");
+
+        pvd::PVStructurePtr ret(pvd::getPVDataCreate()->createPVStructure(O.V->getStructure()));
+        ret->copyUnchecked(*O.V);
+
+        pvd::BitSet::shared_pointer changed(new pvd::BitSet(ret->getNextFieldOffset()));
+        diff_field(*ret, *SELF.V, *changed, false);
+
+        return P4PValue_wrap(Py_TYPE(self), ret, changed);
+    }CATCH()
+    return NULL;
+}
+
+PyObject* P4PValue_assign_changed(PyObject *self, PyObject *args, PyObject *kws)
+{
+    static const char* names[] = {"other", NULL};
+    PyObject *other;
+    if(!PyArg_ParseTupleAndKeywords(args, kws, "O!", (char**)names, &P4PValue::type, &other))
+        return NULL;
+    TRY {
+        const Value& O = P4PValue::unwrap(other).sync();
+
+        if(SELF.V->getStructure()!=O.V->getStructure() && *SELF.V->getStructure()!=*O.V->getStructure())
+            return PyErr_Format(PyExc_ValueError, "assign_changed() requires Values of the same type");
+
+        SELF.writable();
+
+        pvd::BitSet junk;
+        bool any = diff_field(*SELF.V, *O.V, SELF.I ? *SELF.I : junk, true);
+
+        if(any)
+            Py_RETURN_TRUE;
+        else
+            Py_RETURN_FALSE;
+    }CATCH()
+    return NULL;
+}
+
+// append dotted names of fields of SELF.V set in 'mask'.
+// NULL, or bit 0 or SELF.V itself set, is treated as all fields set.
+void maskNames(Value& SELF, const pvd::BitSet* mask, bool expand, bool parents, PyObject *list)
+{
+    const pvd::Structure *type = SELF.V->getStructure().get();
+    if(!SELF.index || !SELF.index->valid(type))
+        SELF.index = FieldIndex::lookup(*SELF.V);
+    // interned dotted names, relative to SELF.V
+    PyObject *offsets = SELF.index->offsets;
+
+    size_t b0 = SELF.V->getFieldOffset(),
+           b1 = SELF.V->getNextFieldOffset();
+
+    pvd::BitSet changed;
+    if(mask && !mask->get(0) && !mask->get(b0)) {
+        changed = *mask;
+    } else {
+        // no tracking, or all changed
+        for(size_t i=b0+1; i<b1; i++)
+            changed.set(i);
+    }
+
+    for(pvd::int32 i=changed.nextSetBit(b0+1); i>=0 && size_t(i)<b1; i=changed.nextSetBit(i+1)) {
+        if(!expand && !parents) {
+            if(PyList_Append(list, PyTuple_GET_ITEM(offsets, i-b0)))
+                throw std::runtime_error("XXX");
+            continue;
+        }
+
+        const pvd::PVField& subfld = *SELF.V->getSubFieldT(i);
+        if(!expand || subfld.getField()->getType()!=pvd::structure) {
+            if(PyList_Append(list, PyTuple_GET_ITEM(offsets, i-b0)))
+                throw std::runtime_error("XXX");
+
+        } else {
+            for(size_t j=i+1, J=subfld.getNextFieldOffset(); j<J; j++) {
+                changed.set(j);
+            }
+        }
+        if(parents) {
+            // all parents except SELF.V
+            for(const pvd::PVStructure *parent = subfld.getParent(); parent && parent!=SELF.V.get(); parent=parent->getParent()) {
+                if(PyList_Append(list, PyTuple_GET_ITEM(offsets, parent->getFieldOffset()-b0)))
+                    throw std::runtime_error("XXX");
+            }
+        }
+    }
+}
+
+void changedNames(Value& SELF, bool expand, bool parents, PyObject *list)
+{
+    maskNames(SELF, SELF.I.get(), expand, parents, list);
+}
+
 PyObject* P4PValue_changedSet(PyObject *self, PyObject *args, PyObject *kws)
 {
     static const char* names[] = {"expand", "parents", NULL};
@@ -1290,51 +2614,97 @@ PyObject* P4PValue_changedSet(PyObject *self, PyObject *args, PyObject *kws)
     if(!PyArg_ParseTupleAndKeywords(args, kws, "|OO", (char**)names, &pyexpand, &pyparents))
         return NULL;
     TRY {
-        // use of PVField::getFullName() prefixes with names of parents,
-        // which can't be used to index of this sub-structure.
-        if(SELF.V->getParent())
-            return PyErr_Format(PyExc_NotImplementedError, "changedSet not implemented for sub-struct");
+        PyRef list(PyList_New(0));
 
-        size_t b0 = SELF.V->getFieldOffset(),
-               b1 = SELF.V->getNextFieldOffset();
+        changedNames(SELF, PyObject_IsTrue(pyexpand), PyObject_IsTrue(pyparents), list.get());
 
-        bool expand = PyObject_IsTrue(pyexpand);
-        bool parents = PyObject_IsTrue(pyparents);
+        return PySet_New(list.get());
+    }CATCH()
+    return NULL;
+}
 
-        pvd::BitSet changed;
-        if(SELF.I && !SELF.I->get(0)) {
-            changed = *SELF.I;
+PyObject* P4PValue_overrunSet(PyObject *self, PyObject *args, PyObject *kws)
+{
+    static const char* names[] = {"expand", "parents", NULL};
+    PyObject *pyexpand = Py_False, *pyparents = Py_False;
+    if(!PyArg_ParseTupleAndKeywords(args, kws, "|OO", (char**)names, &pyexpand, &pyparents))
+        return NULL;
+    TRY {
+        PyRef list(PyList_New(0));
+
+        if(SELF.root && SELF.root->overrun)
+            maskNames(SELF, SELF.root->overrun.get(), PyObject_IsTrue(pyexpand), PyObject_IsTrue(pyparents), list.get());
+
+        return PySet_New(list.get());
+    }CATCH()
+    return NULL;
+}
+
+PyObject* P4PValue_iterChanged(PyObject *self, PyObject *args, PyObject *kws)
+{
+    static const char* names[] = {"expand", NULL};
+    PyObject *pyexpand = Py_False;
+    if(!PyArg_ParseTupleAndKeywords(args, kws, "|O", (char**)names, &pyexpand))
+        return NULL;
+    TRY {
+        const pvd::Structure *type = SELF.V->getStructure().get();
+        if(!SELF.index || !SELF.index->valid(type))
+            SELF.index = FieldIndex::lookup(*SELF.V);
+
+        PyRef ret(P4PChangedIter::type.tp_new(&P4PChangedIter::type, NULL, NULL));
+        ChangedIter& it = P4PChangedIter::unwrap(ret.get());
+
+        it.V = SELF.V;
+        it.index = SELF.index;
+        it.expand = PyObject_IsTrue(pyexpand);
+        it.b0 = SELF.V->getFieldOffset();
+        it.b1 = SELF.V->getNextFieldOffset();
+        it.next = it.b0+1u;
+
+        const pvd::BitSet* mask = SELF.I.get();
+        if(mask && !mask->get(0) && !mask->get(it.b0)) {
+            it.changed = *mask;
         } else {
             // no tracking, or all changed
-            for(size_t i=b0+1; i<b1; i++)
-                changed.set(i);
+            it.allUntil = it.b1;
         }
 
-        PyRef ret(PySet_New(NULL));
+        return ret.release();
+    }CATCH()
+    return NULL;
+}
 
-        for(pvd::int32 i=changed.nextSetBit(b0+1); i>=0 && size_t(i)<b1; i=changed.nextSetBit(i+1)) {
-            const pvd::PVField& subfld = *SELF.V->getSubFieldT(i);
-            if(!expand || subfld.getField()->getType()!=pvd::structure) {
-                PyRef N(PyUnicode_FromString(subfld.getFullName().c_str()));
-                if(PySet_Add(ret.get(), N.get()))
-                    return NULL;
+// as maskNames(SELF, SELF.I, expand, false), one name per call
+PyObject* P4PChangedIter_next(PyObject *self)
+{
+    try {
+        ChangedIter& it = P4PChangedIter::unwrap(self);
 
-            } else {
-                for(size_t j=i+1, J=subfld.getNextFieldOffset(); j<J; j++) {
-                    changed.set(j);
-                }
+        while(true) {
+            size_t i = it.next;
+            if(i >= it.allUntil) {
+                pvd::int32 n = it.changed.nextSetBit(i);
+                if(n<0)
+                    return NULL; // StopIteration
+                i = n;
             }
-            if(parents) {
-                // all parents except the root
-                for(const pvd::PVStructure *parent = subfld.getParent(); parent && parent->getParent(); parent=parent->getParent()) {
-                    PyRef N(PyUnicode_FromString(parent->getFullName().c_str()));
-                    if(PySet_Add(ret.get(), N.get()))
-                        return NULL;
+            if(i >= it.b1)
+                return NULL;
+            it.next = i+1u;
+
+            if(it.expand) {
+                const pvd::PVField& subfld = *it.V->getSubFieldT(i);
+                if(subfld.getField()->getType()==pvd::structure) {
+                    // all of its sub-fields
+                    it.allUntil = std::max(it.allUntil, subfld.getNextFieldOffset());
+                    continue;
                 }
             }
-        }
 
-        return ret.release();
+            PyObject *name = PyTuple_GET_ITEM(it.index->offsets, i-it.b0);
+            Py_INCREF(name);
+            return name;
+        }
     }CATCH()
     return NULL;
 }
@@ -1371,16 +2741,17 @@ Py_ssize_t P4PValue_len(PyObject *self)
 int P4PValue_setitem(PyObject *self, PyObject *name, PyObject *value)
 {
     TRY {
+        SELF.writable();
+
         pvd::PVFieldPtr fld;
         if(name == Py_None) {
             fld = SELF.V;
             assert(!!fld);
 
         } else {
-            PyString S(name);
-            fld = SELF.V->getSubField(S.str());
+            fld = SELF.lookup(name);
             if(!fld) {
-                PyErr_SetString(PyExc_KeyError, S.str().c_str());
+                PyErr_SetObject(PyExc_KeyError, name);
                 return -1;
             }
         }
@@ -1399,10 +2770,9 @@ int P4PValue_setitem(PyObject *self, PyObject *name, PyObject *value)
 PyObject* P4PValue_getitem(PyObject *self, PyObject *name)
 {
     TRY {
-        PyString S(name);
-        pvd::PVFieldPtr fld = SELF.V->getSubField(S.str());
+        pvd::PVFieldPtr fld = SELF.lookup(name);
         if(!fld) {
-            PyErr_SetString(PyExc_KeyError, S.str().c_str());
+            PyErr_SetObject(PyExc_KeyError, name);
             return NULL;
         }
 
@@ -1423,11 +2793,21 @@ PyMappingMethods P4PValue_mapping = {
 
 static PyMethodDef P4PValue_methods[] = {
     {"tolist", (PyCFunction)&P4PValue_toList, METH_VARARGS|METH_KEYWORDS,
-     "tolist(name=None)\n\n"
-     "Recursively transform into a list of tuples."},
+     "tolist(name=None, changed_only=False)\n\n"
+     "Recursively transform into a list of tuples.\n"
+     "If changed_only=True, include only fields marked as changed (and their parents)."},
      {"todict", (PyCFunction)&P4PValue_toDict, METH_VARARGS|METH_KEYWORDS,
-      "todict(name=None, type=dict)\n\n"
-      "Recursively transform into a dictionary (or other type constructable from a list of tuples)."},
+      "todict(name=None, type=dict, changed_only=False)\n\n"
+      "Recursively transform into a dictionary (or other type constructable from a list of tuples).\n"
+      "If changed_only=True, include only fields marked as changed (and their parents)."},
+    {"tocolumns", (PyCFunction)&P4PValue_toColumns, METH_VARARGS|METH_KEYWORDS,
+     "tocolumns(name=None, structured=False) -> dict|numpy.ndarray\n\n"
+     "Extract a table-like field, either a structure of scalar arrays or an array of structures of scalars.\n"
+     "Returns a dict of column arrays, or a numpy structured array if structured=True."},
+    {"fromcolumns", (PyCFunction)&P4PValue_fromColumns, METH_VARARGS|METH_KEYWORDS,
+     "fromcolumns(value, name=None)\n\n"
+     "Assign a table-like field from a dict of column arrays, or a numpy structured array.\n"
+     "Columns not provided are left unchanged, or default for an array of structures."},
     {"items", (PyCFunction)&P4PValue_items, METH_VARARGS,
      "items( [\"fld\"] )\n\n"
      "Transform into a list of tuples.  Not recursive"},
@@ -1437,9 +2817,11 @@ static PyMethodDef P4PValue_methods[] = {
     {"has", (PyCFunction)&P4PValue_has, METH_VARARGS,
      "has(\"fld\")\n"
      "Test for existance of field"},
-    {"get", (PyCFunction)&P4PValue_get, METH_VARARGS,
-     "get(\"fld\", [default])\n"
-     "Fetch a field value, or a default if it does not exist"},
+    {"get", (PyCFunction)&P4PValue_get, METH_VARARGS|METH_KEYWORDS,
+     "get(\"fld\", [default], lazy=False)\n"
+     "Fetch a field value, or a default if it does not exist.\n"
+     "With lazy=True, a string array is returned as a read-only StringArray, which decodes elements on access,\n"
+     "instead of a list."},
     {"getID", (PyCFunction)&P4PValue_id, METH_NOARGS,
      "getID()\n"
      "Return Structure ID string"},
@@ -1458,8 +2840,34 @@ static PyMethodDef P4PValue_methods[] = {
     {"unmark", (PyCFunction)&P4PValue_unmark, METH_NOARGS,
      "unmark()\n\n"
      "clear all field changed flag."},
+    {"tojson", (PyCFunction)&P4PValue_tojson, METH_VARARGS|METH_KEYWORDS,
+     "tojson(changed_only=False, nan='literal') -> bytes\n\n"
+     "Encode as a UTF-8 JSON object.  If changed_only=True, only fields marked as changed are included.\n"
+     "nan= selects how NaN and Infinity are encoded.  'literal' as NaN, Infinity, and -Infinity (as the python json module),\n"
+     "'null', or 'error' to raise ValueError."},
+    {"fromjson", (PyCFunction)&P4PValue_fromjson, METH_VARARGS|METH_KEYWORDS,
+     "fromjson(data, strict=True)\n\n"
+     "Assign, and mark as changed, fields from a JSON object in bytes or str.\n"
+     "If strict=True, unknown keys are an error.  Otherwise they are ignored."},
+    {"diff", (PyCFunction)&P4PValue_diff, METH_VARARGS|METH_KEYWORDS,
+     "diff(other) -> Value\n\n"
+     "Return a copy of 'other' with only those fields which differ from this Value marked as changed.\n"
+     "Both must have the same type."},
+    {"assign_changed", (PyCFunction)&P4PValue_assign_changed, METH_VARARGS|METH_KEYWORDS,
+     "assign_changed(other) -> bool\n\n"
+     "Copy, and mark as changed, only those fields of 'other' which differ from this Value.\n"
+     "Both must have the same type.  Returns True if any field differed."},
     {"changedSet", (PyCFunction)&P4PValue_changedSet, METH_VARARGS|METH_KEYWORDS,
      "changedSet(expand=False) -> set(['...'])\n\n"},
+    {"iterChanged", (PyCFunction)&P4PValue_iterChanged, METH_VARARGS|METH_KEYWORDS,
+     "iterChanged(expand=False) -> iter(['...'])\n\n"
+     "Iterate the names of fields marked as changed, in field order.\n"
+     "Names are found as the iterator advances, from a copy of the changed mask.\n"
+     "Equivalent to changedSet(expand) without building a set."},
+    {"overrunSet", (PyCFunction)&P4PValue_overrunSet, METH_VARARGS|METH_KEYWORDS,
+     "overrunSet(expand=False, parents=False) -> set(['...'])\n\n"
+     "Names of fields which changed more than once before this subscription update was popped.\n"
+     "Only the latest values of these fields are present.  Empty if not from a subscription."},
     {"tostr", (PyCFunction)&P4PValue_tostr, METH_VARARGS|METH_KEYWORDS,
      "tostr(limit=0) -> str\n"
      "Return a string representation of the Value.  If limit!=0, output is truncated after ~this many charactors."},
@@ -1495,6 +2903,13 @@ void p4p_value_register(PyObject *mod)
     P4PValue::type.tp_methods = P4PValue_methods;
 
     P4PValue::finishType(mod, "ValueBase");
+
+    P4PChangedIter::buildType();
+    P4PChangedIter::type.tp_doc = "Iterator over the names of changed fields of a Value.  See Value.iterChanged()";
+    P4PChangedIter::type.tp_iter = &PyObject_SelfIter;
+    P4PChangedIter::type.tp_iternext = &P4PChangedIter_next;
+
+    P4PChangedIter::finishType(mod, "ChangedIterator");
 }
 
 epics::pvData::PVStructure::shared_pointer P4PValue_unwrap(PyObject *obj,
@@ -1502,12 +2917,47 @@ epics::pvData::PVStructure::shared_pointer P4PValue_unwrap(PyObject *obj,
 {
     if(!PyObject_TypeCheck(obj, &P4PValue::type))
         throw std::runtime_error("Not a _p4p.ValueBase");
-    Value& val = P4PValue::unwrap(obj);
+    Value& val = P4PValue::unwrap(obj).writable();
     if(set && val.I)
         *set = *val.I;
     return val.V;
 }
 
+std::tr1::shared_ptr<const epics::pvData::Serializable> P4PValue_serializer(PyObject *obj, bool delta)
+{
+    Value& SELF = P4PValue::unwrap(obj).sync();
+    std::tr1::shared_ptr<ValueSerial> ret(new ValueSerial);
+    ret->V = SELF.V;
+    ret->delta = delta;
+
+    // a sub-structure is serialized as if it were the top-level structure
+    const size_t off = SELF.V->getFieldOffset(),
+                 end = SELF.V->getNextFieldOffset();
+    bool all = !SELF.I;
+    for(const pvd::PVStructure *S = SELF.V.get(); S && !all; S = S->getParent())
+        all = SELF.I->get(S->getFieldOffset());
+
+    if(all) {
+        ret->changed.set(0);
+    } else {
+        for(pvd::int32 i=SELF.I->nextSetBit(off+1u); i>=0 && size_t(i)<end; i=SELF.I->nextSetBit(i+1))
+            ret->changed.set(i-off);
+    }
+    for(pvd::int32 i=ret->changed.nextSetBit(0); i>=0; i=ret->changed.nextSetBit(i+1))
+        ret->written.set(i+off);
+    return ret;
+}
+
+PyObject *P4PValue_deserialize(epics::pvData::ByteBuffer& buf)
+{
+    ValueSerial ser;
+    pvd::deserializeFromBuffer(&ser, buf);
+
+    pvd::BitSet::shared_pointer changed(new pvd::BitSet);
+    changed->swap(ser.changed);
+    return P4PValue_wrap(P4PValue_type, ser.V, changed);
+}
+
 std::tr1::shared_ptr<epics::pvData::BitSet> P4PValue_unwrap_bitset(PyObject *obj)
 {
     if(!PyObject_TypeCheck(obj, &P4PValue::type))
@@ -1535,6 +2985,8 @@ PyObject *P4PValue_wrap(PyTypeObject *type,
         Value& val = P4PValue::unwrap(ret.get());
         val.V = V;
         val.I = I;
+        val.root.reset(new P4PValueRoot(V));
+        val.top = V.get();
     }
 
     if(type->tp_init(ret.get(), args.get(), kws.get()))
@@ -1542,3 +2994,78 @@ PyObject *P4PValue_wrap(PyTypeObject *type,
 
     return ret.release();
 }
+
+// returns a pooled PVStructure to its pool when the last external reference is released
+struct P4PStructurePool::Recycle {
+    std::tr1::weak_ptr<P4PStructurePool> pool;
+    pvd::PVStructure::shared_pointer elem;
+
+    void operator()(pvd::PVStructure*) {
+        pvd::PVStructure::shared_pointer E;
+        E.swap(elem); // E is now the only reference, unless aliased
+        std::tr1::shared_ptr<P4PStructurePool> P(pool.lock());
+        if(P)
+            P->put(E);
+    }
+};
+
+pvd::PVStructure::shared_pointer P4PStructurePool::copy(const pvd::PVStructure& src)
+{
+    const pvd::StructureConstPtr& stype(src.getStructure());
+    pvd::PVStructure::shared_pointer elem;
+    {
+        Guard G(lock);
+        if(type!=stype && (!type || !(*type==*stype))) {
+            // type change (eg. reconnect) invalidates free list
+            std::vector<pvd::PVStructure::shared_pointer> junk;
+            junk.swap(free);
+            type = stype;
+            UnGuard U(G);
+            junk.clear();
+        } else {
+            while(!elem && !free.empty()) {
+                elem.swap(free.back());
+                free.pop_back();
+                // paranoia.  put() only keeps unreferenced elements
+                if(!elem.unique())
+                    elem.reset();
+            }
+        }
+        copies++;
+        if(elem)
+            recycled++;
+    }
+
+    if(!elem)
+        elem = pvd::getPVDataCreate()->createPVStructure(stype);
+    // arrays are shared, not copied
+    elem->copyUnchecked(src);
+
+    Recycle R;
+    R.pool = shared_from_this();
+    R.elem = elem;
+    return pvd::PVStructure::shared_pointer(elem.get(), R);
+}
+
+void P4PStructurePool::put(const pvd::PVStructure::shared_pointer& elem)
+{
+    // Another reference may have been taken through shared_from_this() (eg. by getSubField())
+    // which outlives the Recycle group.  Then this storage must not be re-used.
+    if(!elem.unique())
+        return;
+    Guard G(lock);
+    if(free.size()<limit && (elem->getStructure()==type || *elem->getStructure()==*type))
+        free.push_back(elem);
+}
+
+PyObject *P4PValue_wrap_shared(PyTypeObject *type,
+                               const std::tr1::shared_ptr<P4PValueRoot>& root,
+                               const epics::pvData::BitSet::shared_pointer& I)
+{
+    PyRef ret(P4PValue_wrap(type, root->root, I));
+
+    Value& val = P4PValue::unwrap(ret.get());
+    val.root = root;
+
+    return ret.release();
+}
@@ -0,0 +1,608 @@
+/* Downstream load client for gateway benchmarking
+ *
+ * Connects to PVs served by benchserver (usually through a gateway)
+ * and drives a configurable number of subscriptions, and GET and PUT
+ * loops against each PV.  Periodically, and at exit, prints
+ * throughput, latency percentiles, and drop/overrun counts.
+ * If the gateway PID is given, also reports its CPU time and RSS
+ * (Linux only, read from /proc).
+ *
+ * Monitor latency is measured from the timeStamp set by benchserver,
+ * so both must run on the same host (or with synchronized clocks).
+ * GET and PUT latency is round trip time.
+ */
+
+#if !defined(_WIN32)
+#include <signal.h>
+#include <unistd.h>
+#define USE_SIGNAL
+#endif
+
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <deque>
+#include <string>
+#include <algorithm>
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <epicsGetopt.h>
+#include <epicsMutex.h>
+#include <epicsGuard.h>
+#include <epicsEvent.h>
+#include <epicsTime.h>
+#include <epicsTypes.h>
+
+#include <pv/sharedPtr.h>
+#include <pv/pvAccess.h>
+#include <pv/createRequest.h>
+#include <pv/logger.h>
+#include <pva/client.h>
+
+namespace  {
+
+namespace pva = epics::pvAccess;
+namespace pvd = epics::pvData;
+
+typedef epicsGuard<epicsMutex> Guard;
+typedef epicsGuardRelease<epicsMutex> UnGuard;
+
+volatile bool running = true;
+
+#ifdef USE_SIGNAL
+void alldone(int num)
+{
+    (void)num;
+    running = false;
+}
+#endif
+
+double now()
+{
+    epicsTimeStamp ts;
+    epicsTimeGetCurrent(&ts);
+    return double(ts.secPastEpoch + POSIX_TIME_AT_EPICS_EPOCH) + ts.nsec*1e-9;
+}
+
+// latency samples, in seconds.
+// Keeps a uniform random sample of at most 'capacity' entries (reservoir sampling)
+// so that memory use does not grow with run time.
+struct Latency {
+    enum {capacity = 100000};
+    std::vector<double> samples;
+    // number of samples add()'d, and the largest
+    size_t count;
+    double worst;
+    epicsUInt32 seed;
+
+    Latency() :count(0u), worst(0.0), seed(0x2545f491) {}
+
+    // xorshift32.  uniform in [0, 1)
+    double uniform()
+    {
+        seed ^= seed<<13;
+        seed ^= seed>>17;
+        seed ^= seed<<5;
+        return seed/4294967296.0;
+    }
+
+    void add(double L)
+    {
+        count++;
+        if(L>worst)
+            worst = L;
+        if(samples.size()<size_t(capacity)) {
+            samples.push_back(L);
+        } else {
+            // replace a random entry with probability capacity/count
+            size_t idx = size_t(uniform()*count);
+            if(idx<samples.size())
+                samples[idx] = L;
+        }
+    }
+
+    void show(std::ostream& strm, const char *label)
+    {
+        strm<<"  "<<std::setw(8)<<std::left<<label<<std::right;
+        if(samples.empty()) {
+            strm<<" no samples\n";
+            return;
+        }
+        std::sort(samples.begin(), samples.end());
+        static const char *pctname[] = {"p50", "p90", "p99", "p99.9"};
+        static const double pct[] = {0.5, 0.9, 0.99, 0.999};
+        strm<<" n="<<count<<std::fixed<<std::setprecision(3);
+        for(size_t i=0; i<sizeof(pct)/sizeof(pct[0]); i++) {
+            size_t idx = size_t(pct[i]*(samples.size()-1u));
+            strm<<" "<<pctname[i]<<"="<<samples[idx]*1e3<<"ms";
+        }
+        strm<<" max="<<worst*1e3<<"ms\n";
+        strm.unsetf(std::ios::floatfield);
+    }
+};
+
+struct Counters {
+    size_t updates, bytes, drops, overruns, disconnects;
+    size_t gets, puts, errors;
+    Counters()
+        :updates(0u), bytes(0u), drops(0u), overruns(0u), disconnects(0u)
+        ,gets(0u), puts(0u), errors(0u)
+    {}
+};
+
+// a GET or PUT which is re-issued on completion
+struct Loop {
+    virtual ~Loop() {}
+    virtual void issue() =0;
+};
+
+struct Bench {
+    epicsMutex mutex;
+    Counters count;
+    Latency monLatency, getLatency, putLatency;
+
+    // GET and PUT loops which have completed and need to be re-issued
+    std::deque<Loop*> ready;
+    epicsEvent wakeup;
+};
+
+Bench bench;
+
+size_t valueBytes(const pvd::PVStructure& root)
+{
+    pvd::PVField::const_shared_pointer fld(root.getSubField("value"));
+    if(!fld)
+        return 0u;
+
+    if(fld->getField()->getType()==pvd::union_) {
+        fld = static_cast<const pvd::PVUnion*>(fld.get())->get();
+        if(!fld)
+            return 0u;
+    }
+
+    if(fld->getField()->getType()==pvd::scalarArray) {
+        const pvd::PVScalarArray* arr = static_cast<const pvd::PVScalarArray*>(fld.get());
+        return arr->getLength() * pvd::ScalarTypeFunc::elementSize(arr->getScalarArray()->getElementType());
+    } else {
+        return 8u;
+    }
+}
+
+struct Subscription : public pvac::ClientChannel::MonitorCallback
+{
+    // guards 'mon' assignment, 'ready', poll(), and sequence tracking
+    epicsMutex pollLock;
+    pvac::Monitor mon;
+    // set after 'mon' is assigned
+    bool ready;
+    bool first;
+    pvd::int32 lastseq;
+
+    Subscription() :ready(false), first(true), lastseq(0) {}
+    virtual ~Subscription() { mon.cancel(); }
+
+    void start(pvac::ClientChannel& chan, const pvd::PVStructure::const_shared_pointer& pvReq)
+    {
+        pvac::Monitor M(chan.monitor(this, pvReq));
+        Guard G(pollLock);
+        mon = M;
+        ready = true;
+        // any Data event before 'ready' was ignored
+        drain();
+    }
+
+    virtual void monitorEvent(const pvac::MonitorEvent& evt) OVERRIDE FINAL
+    {
+        switch(evt.event) {
+        case pvac::MonitorEvent::Fail:
+            std::cerr<<"Subscription error: "<<evt.message<<"\n";
+            {
+                Guard G(bench.mutex);
+                bench.count.errors++;
+            }
+            break;
+        case pvac::MonitorEvent::Cancel:
+            break;
+        case pvac::MonitorEvent::Disconnect:
+            {
+                Guard G(bench.mutex);
+                bench.count.disconnects++;
+            }
+            {
+                Guard G(pollLock);
+                first = true;
+            }
+            break;
+        case pvac::MonitorEvent::Data: {
+            Guard G(pollLock);
+            if(ready)
+                drain(); // otherwise start() will catch up
+        }
+            break;
+        }
+    }
+
+    // call with pollLock held
+    void drain()
+    {
+        while(mon.poll()) {
+            const double T = now();
+
+            pvd::PVLong::const_shared_pointer sec(mon.root->getSubField<pvd::PVLong>("timeStamp.secondsPastEpoch"));
+            pvd::PVInt::const_shared_pointer nsec(mon.root->getSubField<pvd::PVInt>("timeStamp.nanoseconds")),
+                                             tag(mon.root->getSubField<pvd::PVInt>("timeStamp.userTag"));
+            if(!sec || !nsec || !tag) {
+                std::cerr<<"Subscription update missing timeStamp.  Not a benchserver PV?\n";
+                continue;
+            }
+
+            const pvd::int32 seq = tag->get();
+            const bool stamped = mon.changed.get(tag->getFieldOffset());
+
+            Guard G(bench.mutex);
+            bench.count.updates++;
+            bench.count.bytes += valueBytes(*mon.root);
+            if(!mon.overrun.isEmpty())
+                bench.count.overruns++;
+
+            // updates due to PUT (re-posted by benchserver) don't change timeStamp
+            if(!stamped)
+                continue;
+
+            bench.monLatency.add(T - (double(sec->get()) + nsec->get()*1e-9));
+
+            if(!first) {
+                pvd::int32 delta = seq - lastseq;
+                if(delta>1)
+                    bench.count.drops += delta-1;
+            }
+            first = false;
+            lastseq = seq;
+        }
+    }
+};
+
+struct GetLoop : public pvac::ClientChannel::GetCallback, public Loop
+{
+    pvac::ClientChannel chan;
+    pvd::PVStructure::const_shared_pointer pvReq;
+    pvac::Operation op;
+    double start;
+
+    GetLoop(const pvac::ClientChannel& chan, const pvd::PVStructure::const_shared_pointer& pvReq)
+        :chan(chan), pvReq(pvReq), start(0.0) {}
+    virtual ~GetLoop() { op.cancel(); }
+
+    virtual void issue() OVERRIDE FINAL
+    {
+        start = now();
+        op = chan.get(this, pvReq);
+    }
+
+    virtual void getDone(const pvac::GetEvent& evt) OVERRIDE FINAL
+    {
+        const double T = now();
+        {
+            Guard G(bench.mutex);
+            switch(evt.event) {
+            case pvac::GetEvent::Success:
+                bench.count.gets++;
+                bench.count.bytes += valueBytes(*evt.value);
+                bench.getLatency.add(T - start);
+                break;
+            case pvac::GetEvent::Fail:
+                bench.count.errors++;
+                break;
+            case pvac::GetEvent::Cancel:
+                return;
+            }
+            bench.ready.push_back(this);
+        }
+        bench.wakeup.signal();
+    }
+};
+
+struct PutLoop : public pvac::ClientChannel::PutCallback, public Loop
+{
+    pvac::ClientChannel chan;
+    pvd::PVStructure::const_shared_pointer pvReq;
+    pvac::Operation op;
+    double start;
+    pvd::int32 counter;
+
+    PutLoop(const pvac::ClientChannel& chan, const pvd::PVStructure::const_shared_pointer& pvReq)
+        :chan(chan), pvReq(pvReq), start(0.0), counter(0) {}
+    virtual ~PutLoop() { op.cancel(); }
+
+    virtual void issue() OVERRIDE FINAL
+    {
+        start = now();
+        // fetch previous value so that array PVs are written back with the same size
+        op = chan.put(this, pvReq, true);
+    }
+
+    virtual void putBuild(const pvd::StructureConstPtr& build, Args& args) OVERRIDE FINAL
+    {
+        pvd::PVStructurePtr root(build->build());
+        pvd::PVFieldPtr value(root->getSubField("value"));
+        if(!value)
+            throw std::runtime_error("PV has no .value");
+
+        if(value->getField()->getType()==pvd::scalar) {
+            static_cast<pvd::PVScalar*>(value.get())->putFrom<pvd::int32>(counter++);
+        } else if(args.previous) {
+            pvd::PVField::const_shared_pointer prev(args.previous->getSubField("value"));
+            if(prev)
+                value->copyUnchecked(*prev);
+        }
+
+        args.root = root;
+        args.tosend.set(value->getFieldOffset());
+    }
+
+    virtual void putDone(const pvac::PutEvent& evt) OVERRIDE FINAL
+    {
+        const double T = now();
+        {
+            Guard G(bench.mutex);
+            switch(evt.event) {
+            case pvac::PutEvent::Success:
+                bench.count.puts++;
+                bench.putLatency.add(T - start);
+                break;
+            case pvac::PutEvent::Fail:
+                bench.count.errors++;
+                break;
+            case pvac::PutEvent::Cancel:
+                return;
+            }
+            bench.ready.push_back(this);
+        }
+        bench.wakeup.signal();
+    }
+};
+
+struct ProcStat {
+    bool valid;
+    double cpu; // user+system seconds
+    size_t rss, hwm; // kB
+
+    ProcStat() :valid(false), cpu(0.0), rss(0u), hwm(0u) {}
+
+    static ProcStat read(long pid)
+    {
+        ProcStat ret;
+#ifdef __linux__
+        if(pid<=0)
+            return ret;
+        {
+            std::ostringstream name;
+            name<<"/proc/"<<pid<<"/stat";
+            std::ifstream strm(name.str().c_str());
+            std::string line;
+            if(!std::getline(strm, line))
+                return ret;
+            // skip past "pid (comm) ", comm may include spaces
+            size_t paren = line.rfind(')');
+            if(paren==line.npos)
+                return ret;
+            std::istringstream fields(line.substr(paren+2));
+            std::string skip;
+            // fields after comm start with 'state' (#3).  utime and stime are #14 and #15
+            for(unsigned i=3; i<14; i++)
+                fields>>skip;
+            unsigned long long utime=0, stime=0;
+            fields>>utime>>stime;
+            if(!fields)
+                return ret;
+            ret.cpu = double(utime+stime)/sysconf(_SC_CLK_TCK);
+        }
+        {
+            std::ostringstream name;
+            name<<"/proc/"<<pid<<"/status";
+            std::ifstream strm(name.str().c_str());
+            std::string line;
+            while(std::getline(strm, line)) {
+                if(line.compare(0, 6, "VmRSS:")==0)
+                    ret.rss = strtoul(line.c_str()+6, NULL, 10);
+                else if(line.compare(0, 6, "VmHWM:")==0)
+                    ret.hwm = strtoul(line.c_str()+6, NULL, 10);
+            }
+        }
+        ret.valid = true;
+#else
+        (void)pid;
+#endif
+        return ret;
+    }
+};
+
+void report(std::ostream& strm, double interval, const Counters& cur, const Counters& prev,
+            long gwpid, const ProcStat& gwcur, const ProcStat& gwprev)
+{
+    strm<<std::fixed<<std::setprecision(1)
+        <<"updates/s="<<(cur.updates-prev.updates)/interval
+        <<" MB/s="<<(cur.bytes-prev.bytes)/interval/1048576.0
+        <<" gets/s="<<(cur.gets-prev.gets)/interval
+        <<" puts/s="<<(cur.puts-prev.puts)/interval
+        <<" drops="<<cur.drops-prev.drops
+        <<" overruns="<<cur.overruns-prev.overruns
+        <<" errors="<<cur.errors-prev.errors
+        <<" disconnects="<<cur.disconnects-prev.disconnects;
+    if(gwcur.valid && gwprev.valid) {
+        strm<<" gw["<<gwpid<<"] cpu="<<100.0*(gwcur.cpu-gwprev.cpu)/interval<<"%"
+            <<" rss="<<gwcur.rss<<"kB";
+    }
+    strm<<"\n";
+    strm.unsetf(std::ios::floatfield);
+}
+
+void usage(const char *argv0)
+{
+    std::cerr<<"Usage: "<<argv0<<" [-n <count>] [-m <N>] [-g <N>] [-p <N>] [-q <depth>] [-w <sec>] [-i <sec>] [-P <gwpid>] <prefix>\n"
+               "\n"
+               "  -n <count>  Number of PVs.  <prefix>0 through <prefix><count-1> (default 1)\n"
+               "  -m <N>      Subscriptions per PV (default 1)\n"
+               "  -g <N>      Concurrent GET loops per PV (default 0)\n"
+               "  -p <N>      Concurrent PUT loops per PV (default 0)\n"
+               "  -q <depth>  Subscription queueSize (default server choice)\n"
+               "  -w <sec>    Run time.  0 runs until interrupted (default 10)\n"
+               "  -i <sec>    Reporting interval (default 1)\n"
+               "  -P <pid>    Gateway process to sample for CPU and RSS\n"
+               "  -v          Verbose logging\n";
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    unsigned count = 1u, nmon = 1u, nget = 0u, nput = 0u, qdepth = 0u;
+    double runtime = 10.0, interval = 1.0;
+    long gwpid = 0;
+    bool verbose = false;
+
+    {
+        int opt;
+        while((opt = getopt(argc, argv, "hn:m:g:p:q:w:i:P:v"))!=-1) {
+            switch(opt) {
+            case 'n': count = strtoul(optarg, NULL, 0); break;
+            case 'm': nmon = strtoul(optarg, NULL, 0); break;
+            case 'g': nget = strtoul(optarg, NULL, 0); break;
+            case 'p': nput = strtoul(optarg, NULL, 0); break;
+            case 'q': qdepth = strtoul(optarg, NULL, 0); break;
+            case 'w': runtime = strtod(optarg, NULL); break;
+            case 'i': interval = strtod(optarg, NULL); break;
+            case 'P': gwpid = strtol(optarg, NULL, 0); break;
+            case 'v': verbose = true; break;
+            case 'h': usage(argv[0]); return 0;
+            default:
+                usage(argv[0]);
+                return 1;
+            }
+        }
+    }
+
+    if(optind+1!=argc || interval<=0.0) {
+        usage(argv[0]);
+        return 1;
+    }
+    const std::string prefix(argv[optind]);
+
+    if(verbose)
+        SET_LOG_LEVEL(pva::logLevelDebug);
+
+    try {
+        pvd::PVStructure::const_shared_pointer monReq, opReq(pvd::createRequest("field()"));
+        {
+            std::ostringstream req;
+            if(qdepth)
+                req<<"record[queueSize="<<qdepth<<"]";
+            req<<"field()";
+            monReq = pvd::createRequest(req.str());
+        }
+
+        pvac::ClientProvider provider("pva");
+
+        // callbacks must out-live operations, which are cancelled from dtors
+        std::vector<std::tr1::shared_ptr<Subscription> > subs;
+        std::vector<std::tr1::shared_ptr<GetLoop> > gets;
+        std::vector<std::tr1::shared_ptr<PutLoop> > puts;
+
+        for(unsigned i=0; i<count; i++) {
+            std::ostringstream name;
+            name<<prefix<<i;
+
+            pvac::ClientChannel chan(provider.connect(name.str()));
+
+            for(unsigned n=0; n<nmon; n++) {
+                std::tr1::shared_ptr<Subscription> sub(new Subscription);
+                sub->start(chan, monReq);
+                subs.push_back(sub);
+            }
+            for(unsigned n=0; n<nget; n++) {
+                std::tr1::shared_ptr<GetLoop> op(new GetLoop(chan, opReq));
+                op->issue();
+                gets.push_back(op);
+            }
+            for(unsigned n=0; n<nput; n++) {
+                std::tr1::shared_ptr<PutLoop> op(new PutLoop(chan, opReq));
+                op->issue();
+                puts.push_back(op);
+            }
+        }
+
+        std::cout<<"Opened "<<subs.size()<<" subscriptions, "<<gets.size()<<" GET and "
+                 <<puts.size()<<" PUT loops on "<<count<<" PVs"<<std::endl;
+
+#ifdef USE_SIGNAL
+        signal(SIGINT, alldone);
+        signal(SIGTERM, alldone);
+        signal(SIGQUIT, alldone);
+#endif
+
+        const double start = now();
+        const ProcStat gwstart(ProcStat::read(gwpid));
+        double lastReport = start;
+        Counters prev;
+        ProcStat gwprev(gwstart);
+
+        while(running) {
+            const double T = now();
+            if(runtime>0.0 && T-start >= runtime)
+                break;
+
+            if(T-lastReport >= interval) {
+                Counters cur;
+                {
+                    Guard G(bench.mutex);
+                    cur = bench.count;
+                }
+                ProcStat gwcur(ProcStat::read(gwpid));
+                report(std::cout, T-lastReport, cur, prev, gwpid, gwcur, gwprev);
+                prev = cur;
+                gwprev = gwcur;
+                lastReport = T;
+            }
+
+            bench.wakeup.wait(std::max(0.0, std::min(interval-(now()-lastReport), 0.1)));
+
+            // re-issue completed GET/PUT
+            Guard G(bench.mutex);
+            while(!bench.ready.empty()) {
+                Loop *loop = bench.ready.front();
+                bench.ready.pop_front();
+                UnGuard U(G);
+                loop->issue();
+            }
+        }
+
+        const double elapsed = now()-start;
+        const ProcStat gwend(ProcStat::read(gwpid));
+
+        // cancel before summarizing
+        subs.clear();
+        gets.clear();
+        puts.clear();
+
+        Guard G(bench.mutex);
+
+        std::cout<<"\nSummary over "<<elapsed<<" sec\n";
+        report(std::cout, elapsed, bench.count, Counters(), gwpid, gwend, gwstart);
+        if(gwend.valid)
+            std::cout<<"  gateway peak RSS "<<gwend.hwm<<"kB\n";
+        std::cout<<"Latency\n";
+        bench.monLatency.show(std::cout, "monitor");
+        bench.getLatency.show(std::cout, "get");
+        bench.putLatency.show(std::cout, "put");
+
+    }catch(std::exception& e){
+        std::cerr<<"Error: "<<e.what()<<"\n";
+        return 1;
+    }
+
+    return 0;
+}
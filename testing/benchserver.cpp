@@ -0,0 +1,309 @@
+/* Upstream server for gateway benchmarking
+ *
+ * Serves a set of PVs named <prefix><N> which are updated at a fixed rate.
+ * Each update carries a sequence number in timeStamp.userTag,
+ * and the time of posting in timeStamp, so that a client (see benchclient.cpp)
+ * can detect dropped updates and measure end-to-end latency.
+ *
+ * PUTs are accepted and re-posted (mailbox).
+ */
+
+#if !defined(_WIN32)
+#include <signal.h>
+#define USE_SIGNAL
+#endif
+
+#include <iostream>
+#include <sstream>
+#include <vector>
+#include <string>
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <epicsGetopt.h>
+#include <epicsGuard.h>
+#include <epicsEvent.h>
+#include <epicsTime.h>
+#include <epicsThread.h>
+
+#include <pv/sharedPtr.h>
+#include <pv/pvAccess.h>
+#include <pv/serverContext.h>
+#include <pv/logger.h>
+#include <pva/server.h>
+#include <pva/sharedstate.h>
+
+namespace  {
+
+namespace pva = epics::pvAccess;
+namespace pvd = epics::pvData;
+
+epicsEvent done;
+volatile bool running = true;
+
+#ifdef USE_SIGNAL
+void alldone(int num)
+{
+    (void)num;
+    running = false;
+    done.signal();
+}
+#endif
+
+pvd::StructureConstPtr buildType(const std::string& kind)
+{
+    pvd::FieldCreatePtr fcreate(pvd::getFieldCreate());
+    pvd::StandardFieldPtr sfld(pvd::getStandardField());
+
+    if(kind=="scalar") {
+        return fcreate->createFieldBuilder()
+                ->setId("epics:nt/NTScalar:1.0")
+                ->add("value", pvd::pvDouble)
+                ->add("alarm", sfld->alarm())
+                ->add("timeStamp", sfld->timeStamp())
+                ->createStructure();
+
+    } else if(kind=="waveform") {
+        return fcreate->createFieldBuilder()
+                ->setId("epics:nt/NTScalarArray:1.0")
+                ->addArray("value", pvd::pvDouble)
+                ->add("alarm", sfld->alarm())
+                ->add("timeStamp", sfld->timeStamp())
+                ->createStructure();
+
+    } else if(kind=="ndarray") {
+        // a subset of NTNDArray, sufficient to exercise the same code paths
+        return fcreate->createFieldBuilder()
+                ->setId("epics:nt/NTNDArray:1.0")
+                ->addNestedUnion("value")
+                    ->addArray("ubyteValue", pvd::pvUByte)
+                    ->addArray("ushortValue", pvd::pvUShort)
+                    ->addArray("doubleValue", pvd::pvDouble)
+                ->endNested()
+                ->add("codec", fcreate->createFieldBuilder()
+                      ->setId("codec_t")
+                      ->add("name", pvd::pvString)
+                      ->add("parameters", fcreate->createVariantUnion())
+                      ->createStructure())
+                ->add("compressedSize", pvd::pvLong)
+                ->add("uncompressedSize", pvd::pvLong)
+                ->addNestedStructureArray("dimension")
+                    ->setId("dimension_t")
+                    ->add("size", pvd::pvInt)
+                    ->add("offset", pvd::pvInt)
+                    ->add("fullSize", pvd::pvInt)
+                    ->add("binning", pvd::pvInt)
+                    ->add("reverse", pvd::pvBoolean)
+                ->endNested()
+                ->add("uniqueId", pvd::pvInt)
+                ->add("dataTimeStamp", sfld->timeStamp())
+                ->add("alarm", sfld->alarm())
+                ->add("timeStamp", sfld->timeStamp())
+                ->createStructure();
+
+    } else {
+        throw std::runtime_error("Unknown type.  Must be one of: scalar, waveform, ndarray");
+    }
+}
+
+struct BenchPV {
+    pvas::SharedPV::shared_pointer pv;
+    pvd::PVStructurePtr scratch;
+    pvd::BitSet changed;
+
+    pvd::PVScalarPtr value;
+    pvd::PVLongPtr sec;
+    pvd::PVIntPtr nsec, tag, uniqueId;
+};
+
+void usage(const char *argv0)
+{
+    std::cerr<<"Usage: "<<argv0<<" [-n <count>] [-t scalar|waveform|ndarray] [-s <elements>] [-r <Hz>] <prefix>\n"
+               "\n"
+               "  -n <count>     Number of PVs to serve.  <prefix>0 through <prefix><count-1> (default 1)\n"
+               "  -t <type>      Value type.  scalar, waveform, or ndarray (default scalar)\n"
+               "  -s <elements>  Array length for waveform and ndarray (default 1024)\n"
+               "  -r <Hz>        Update rate of each PV.  0 disables updates (default 10)\n"
+               "  -v             Verbose logging\n";
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    unsigned count = 1u;
+    std::string kind("scalar");
+    size_t nelem = 1024u;
+    double rate = 10.0;
+    bool verbose = false;
+
+    {
+        int opt;
+        while((opt = getopt(argc, argv, "hn:t:s:r:v"))!=-1) {
+            switch(opt) {
+            case 'n': count = strtoul(optarg, NULL, 0); break;
+            case 't': kind = optarg; break;
+            case 's': nelem = strtoul(optarg, NULL, 0); break;
+            case 'r': rate = strtod(optarg, NULL); break;
+            case 'v': verbose = true; break;
+            case 'h': usage(argv[0]); return 0;
+            default:
+                usage(argv[0]);
+                return 1;
+            }
+        }
+    }
+
+    if(optind+1!=argc) {
+        usage(argv[0]);
+        return 1;
+    }
+    const std::string prefix(argv[optind]);
+
+    if(verbose)
+        SET_LOG_LEVEL(pva::logLevelDebug);
+
+    try {
+        pvd::StructureConstPtr type(buildType(kind));
+
+        // all PVs share the same (immutable) array storage, so updates
+        // exercise the network path rather than our allocator.
+        pvd::shared_vector<const pvd::uint8> bytes;
+        pvd::shared_vector<const double> doubles;
+        {
+            pvd::shared_vector<pvd::uint8> B(nelem);
+            pvd::shared_vector<double> D(nelem);
+            for(size_t i=0; i<nelem; i++) {
+                B[i] = pvd::uint8(i);
+                D[i] = double(i);
+            }
+            bytes = pvd::freeze(B);
+            doubles = pvd::freeze(D);
+        }
+
+        pvas::StaticProvider provider("bench");
+        std::vector<BenchPV> pvs(count);
+
+        for(unsigned i=0; i<count; i++) {
+            BenchPV& bpv = pvs[i];
+
+            bpv.pv = pvas::SharedPV::buildMailbox();
+            bpv.scratch = type->build();
+            bpv.changed.resize(bpv.scratch->getNumberFields());
+
+            bpv.sec = bpv.scratch->getSubFieldT<pvd::PVLong>("timeStamp.secondsPastEpoch");
+            bpv.nsec = bpv.scratch->getSubFieldT<pvd::PVInt>("timeStamp.nanoseconds");
+            bpv.tag = bpv.scratch->getSubFieldT<pvd::PVInt>("timeStamp.userTag");
+
+            if(kind=="scalar") {
+                bpv.value = bpv.scratch->getSubFieldT<pvd::PVScalar>("value");
+
+            } else if(kind=="waveform") {
+                bpv.scratch->getSubFieldT<pvd::PVDoubleArray>("value")->replace(doubles);
+
+            } else { // ndarray
+                pvd::PVUnionPtr U(bpv.scratch->getSubFieldT<pvd::PVUnion>("value"));
+                U->select<pvd::PVUByteArray>("ubyteValue")->replace(bytes);
+
+                bpv.scratch->getSubFieldT<pvd::PVLong>("compressedSize")->put(nelem);
+                bpv.scratch->getSubFieldT<pvd::PVLong>("uncompressedSize")->put(nelem);
+
+                pvd::PVStructureArrayPtr dims(bpv.scratch->getSubFieldT<pvd::PVStructureArray>("dimension"));
+                pvd::PVStructureArray::svector D(1);
+                D[0] = pvd::getPVDataCreate()->createPVStructure(dims->getStructureArray()->getStructure());
+                D[0]->getSubFieldT<pvd::PVInt>("size")->put(nelem);
+                D[0]->getSubFieldT<pvd::PVInt>("fullSize")->put(nelem);
+                D[0]->getSubFieldT<pvd::PVInt>("binning")->put(1);
+                dims->replace(pvd::freeze(D));
+
+                bpv.uniqueId = bpv.scratch->getSubFieldT<pvd::PVInt>("uniqueId");
+            }
+
+            bpv.pv->open(*bpv.scratch);
+
+            std::ostringstream name;
+            name<<prefix<<i;
+            provider.add(name.str(), bpv.pv);
+        }
+
+        pva::ServerContext::shared_pointer server(pva::ServerContext::create(pva::ServerContext::Config()
+                                                                             .provider(provider.provider())
+                                                                             ));
+
+        std::cout<<"Serving "<<count<<" "<<kind<<" PVs "<<prefix<<"0 .. "<<prefix<<(count-1)
+                 <<" at "<<rate<<" Hz"<<std::endl;
+        if(verbose)
+            server->printInfo();
+
+#ifdef USE_SIGNAL
+        signal(SIGINT, alldone);
+        signal(SIGTERM, alldone);
+        signal(SIGQUIT, alldone);
+#endif
+
+        if(rate<=0.0) {
+            done.wait();
+
+        } else {
+            const double period = 1.0/rate;
+            epicsTime next(epicsTime::getCurrent());
+            pvd::int32 seq = 0;
+
+            while(running) {
+                seq++;
+
+                for(size_t i=0; i<pvs.size(); i++) {
+                    BenchPV& bpv = pvs[i];
+                    bpv.changed.clear();
+
+                    // stamp each PV individually so that measured latency excludes
+                    // the time spent posting to preceding PVs.
+                    epicsTimeStamp now;
+                    epicsTimeGetCurrent(&now);
+
+                    bpv.sec->put(pvd::int64(now.secPastEpoch) + POSIX_TIME_AT_EPICS_EPOCH);
+                    bpv.nsec->put(now.nsec);
+                    bpv.tag->put(seq);
+                    bpv.changed.set(bpv.sec->getFieldOffset())
+                               .set(bpv.nsec->getFieldOffset())
+                               .set(bpv.tag->getFieldOffset());
+
+                    if(bpv.value) {
+                        bpv.value->putFrom<pvd::int32>(seq);
+                        bpv.changed.set(bpv.value->getFieldOffset());
+
+                    } else {
+                        // array storage is unchanged, but is re-sent
+                        bpv.changed.set(bpv.scratch->getSubFieldT<pvd::PVField>("value")->getFieldOffset());
+                    }
+                    if(bpv.uniqueId) {
+                        bpv.uniqueId->put(seq);
+                        bpv.changed.set(bpv.uniqueId->getFieldOffset());
+                    }
+
+                    bpv.pv->post(*bpv.scratch, bpv.changed);
+                }
+
+                next += period;
+                double delay = next - epicsTime::getCurrent();
+                if(delay>0.0) {
+                    done.wait(delay);
+
+                } else if(delay < -1.0) {
+                    // fell far behind.  don't try to catch up.
+                    std::cerr<<"Update loop overloaded, skipping "<<(-delay)<<" sec\n";
+                    next = epicsTime::getCurrent();
+                }
+            }
+        }
+
+        std::cout<<"Done"<<std::endl;
+
+    }catch(std::exception& e){
+        std::cerr<<"Error: "<<e.what()<<"\n";
+        return 1;
+    }
+
+    return 0;
+}
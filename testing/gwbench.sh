@@ -0,0 +1,77 @@
+#!/bin/sh
+# Run benchserver -> gateway -> benchclient on the loopback interface.
+#
+# Usage: gwbench.sh [benchclient options...]
+#
+# Environment:
+#   PYTHON      Interpreter with p4p importable (default: python)
+#   BINDIR      Location of benchserver and benchclient executables
+#   SERVER_ARGS Arguments for benchserver (default: "-n 100 -t scalar -r 10")
+#
+# eg.
+#   SERVER_ARGS="-n 10 -t ndarray -s 1000000 -r 10" ./gwbench.sh -n 10 -m 4 -w 30
+set -e
+
+PYTHON="${PYTHON:-python}"
+BINDIR="${BINDIR:-$(dirname "$0")/O.$EPICS_HOST_ARCH}"
+SERVER_ARGS="${SERVER_ARGS:--n 100 -t scalar -r 10}"
+PREFIX="bench:"
+
+TDIR=`mktemp -d`
+SPID=
+GPID=
+cleanup() {
+    [ "$GPID" ] && kill $GPID 2>/dev/null || true
+    [ "$SPID" ] && kill $SPID 2>/dev/null || true
+    wait
+    rm -rf "$TDIR"
+}
+trap cleanup EXIT INT TERM
+
+# upstream server on 127.0.0.1:5085/5086, gateway downstream server on 127.0.0.1:5075/5076
+cat << EOC > "$TDIR/gw.conf"
+{
+    "version":2,
+    "clients":[
+        {
+            "name":"upstream",
+            "provider":"pva",
+            "addrlist":"127.0.0.1",
+            "autoaddrlist":false,
+            "bcastport":5086
+        }
+    ],
+    "servers":[
+        {
+            "name":"downstream",
+            "clients":["upstream"],
+            "interface":["127.0.0.1"],
+            "addrlist":"127.0.0.1",
+            "autoaddrlist":false,
+            "serverport":5075,
+            "bcastport":5076,
+            "statusprefix":"GW:STS:"
+        }
+    ]
+}
+EOC
+
+EPICS_PVAS_INTF_ADDR_LIST=127.0.0.1 \
+EPICS_PVAS_BEACON_ADDR_LIST=127.0.0.1 \
+EPICS_PVAS_AUTO_BEACON_ADDR_LIST=NO \
+EPICS_PVAS_SERVER_PORT=5085 \
+EPICS_PVAS_BROADCAST_PORT=5086 \
+"$BINDIR/benchserver" $SERVER_ARGS "$PREFIX" &
+SPID=$!
+
+"$PYTHON" -m p4p.gw "$TDIR/gw.conf" &
+GPID=$!
+
+# allow gateway to start
+sleep 2
+
+EPICS_PVA_ADDR_LIST=127.0.0.1 \
+EPICS_PVA_AUTO_ADDR_LIST=NO \
+EPICS_PVA_SERVER_PORT=5075 \
+EPICS_PVA_BROADCAST_PORT=5076 \
+"$BINDIR/benchclient" -P $GPID "$@" "$PREFIX"